@@ -32,13 +32,19 @@
 // self
 //
 #include    "libtld/tld.h"
+#include    "libtld/tld_context.h"
 #include    "libtld/tld_data.h"
 #include    "libtld/tld_file.h"
 
 
 // C++
 //
+#include    <atomic>
+#include    <chrono>
+#include    <mutex>
 #include    <sstream>
+#include    <thread>
+#include    <vector>
 
 
 // C
@@ -54,6 +60,10 @@
 #include    <string.h>
 #include    <ctype.h>
 
+#ifdef __SSE2__
+#include    <emmintrin.h>
+#endif
+
 #ifdef WIN32
 #define strncasecmp _strnicmp
 #endif
@@ -85,10 +95,34 @@ extern "C" {
  *
  * \li tld_version() -- return a string representing the TLD library version
  * \li tld() -- find the position of the TLD of any URI
+ * \li tld_n() -- same as tld() with a URI which is not null terminated
+ * \li tld_suffix_offset() -- only return the offset of the TLD
+ * \li tld_split_domain() -- find the sub-domains, domain, and TLD of a
+ *     domain name without allocating anything
+ * \li tld_is_public_suffix() -- check whether a name is a TLD
+ * \li tld_same_site() -- check whether two names have the same
+ *     registrable domain
+ * \li tld_wire() -- same as tld() with a name in DNS wire format
+ * \li tld_labels() -- same as tld() with a name already split in labels
+ * \li tld_lite() -- same as tld_n() with a smaller result which only
+ *     includes the fields you ask for
  * \li tld_domain_to_lowercase() -- force lowercase on the domain name before
  *                                  calling other tld function
  * \li tld_check_uri() -- verify a full URI, with scheme, path, etc.
+ * \li tld_check_uri_n() -- same as tld_check_uri() with a URI which is not
+ *                          null terminated
+ * \li tld_protocols_compile() -- compile a list of protocols once
+ * \li tld_protocols_free() -- release the compiled protocols
+ * \li tld_check_uri_ex() -- same as tld_check_uri_n() with compiled protocols
+ * \li tld_check_uri_parts() -- same as tld_check_uri_ex() and also return
+ *                              the position of each part of the URI
  * \li tld_clear_info() -- reset a tld_info structure for use with tld()
+ * \li tld_clear_info_lite() -- reset a tld_info_lite structure
+ * \li tld_reload_tlds() -- replace the TLDs while other threads use them
+ * \li tld_context_load() -- load a set of TLDs in a context of your own
+ * \li tld_context_free() -- release a context
+ * \li tld_ctx(), tld_ctx_n(), tld_ctx_check_uri(), etc. -- same as the
+ *     functions without "ctx_" using the TLDs of a context
  * \li tld_status_string() -- convert a status to a string
  * \li tld_email_alloc() -- allocate a tld_email_list object
  * \li tld_email_free() -- free a tld_email_list object
@@ -315,29 +349,97 @@ extern "C" {
  */
 
 
-/** \brief The TLD file currently loaded or NULL.
+/** \brief A hash table used to search the TLDs.
+ *
+ * The descriptions are sorted so the search() function can run a binary
+ * search at each level. Each probe of a binary search is likely a cache
+ * miss, though. To avoid that cost, we build this open addressing hash
+ * table each time a TLD file gets loaded. The hash_search() function can
+ * then find a TLD with one or two probes.
+ *
+ * The key of an entry is the start offset of the level (the top level
+ * start offset or the f_start_offset of the parent description) and the
+ * name of the TLD. Each slot holds the top 16 bits of the hash in its
+ * top 16 bits and the index of the description plus one in its lower
+ * 16 bits. A slot set to zero is empty.
+ *
+ * When the table cannot be built (i.e. out of memory), f_slots remains
+ * a null pointer and the lookups fall back to the search() function.
+ */
+struct tld_hash_index
+{
+    uint32_t                    f_mask;
+    uint32_t *                  f_slots;
+};
+
+
+/** \brief The tld_info fields of a description.
+ *
+ * The category and country of a TLD are defined in its tags. Instead of
+ * searching the tags each time a TLD is found, we resolve them once when
+ * the TLD file gets loaded. The context has one of these structures per
+ * description, in the same order as the descriptions.
+ *
+ * The f_country field is the identifier of the country string or 0 when
+ * the TLD has no country (or the name is too long for tld_info).
+ */
+struct tld_description_info
+{
+    uint32_t                    f_country;
+    uint8_t                     f_category;
+};
+
+
+/** \brief A set of TLDs and the data used to search them.
+ *
+ * A context holds one TLD file, its hash index, and the tld_info fields
+ * of its descriptions. The lookup functions
+ * only read the context so any number of threads can use the same
+ * context at the same time.
+ *
+ * The tld_ctx_...() functions use the context you pass to them. You
+ * create such a context with tld_context_load() and release it with
+ * tld_context_free(). This way a process can work with several sets of
+ * TLDs and it can load a new set while threads still use the old one.
+ *
+ * The functions without a context parameter (tld(), tld_check_uri(),
+ * etc.) use a default context, g_tld_context.
+ */
+struct tld_context
+{
+    struct tld_file *           f_file;
+    struct tld_hash_index       f_hash_index;
+    struct tld_description_info *
+                                f_description_infos;
+};
+
+
+/** \brief The default context.
  *
- * This pointer is the TLD file that was specifically or automatically loaded.
- * The tld() function calls the tld_load_tlds() if this pointer is still NULL.
- * This loads the TLDs in memory.
+ * This context holds the TLD file that was specifically or automatically
+ * loaded. The tld() function calls the tld_load_tlds() if the file is
+ * still NULL. This loads the TLDs in memory.
  *
  * You can change the TLDs at any one time by calling the tld_load_tlds()
  * again.
  *
  * \par Thread Safety
  *
- * The loading of the TLDs is not thread safe. If you want to use the library
- * in a multi-threaded environment, make sure to call the tld_load_tlds()
- * before you start your threads. Then you'll be safe as long as you do not
- * want to reload a file of TLDs while running your threads.
+ * The loading of the TLDs in the default context is not thread safe. If
+ * you want to use the library in a multi-threaded environment, make sure
+ * to call the tld_load_tlds() before you start your threads. Then you'll
+ * be safe as long as you do not want to reload a file of TLDs while
+ * running your threads. If you need to load the TLDs while threads run,
+ * call tld_reload_tlds() which replaces this context with a new one, or
+ * use your own context instead (see tld_context_load()).
  *
  * \par Making Sure TLDs Are Loaded
  *
- * The tld_load_tlds_if_not_loaded() can be used to load the TLDs if the
- * g_tld_file is still a null pointer. At the moment, this is only an
- * internal function.
+ * The context_ready() function loads the TLDs if the
+ * g_tld_context.f_file is still a null pointer. At the moment, this is
+ * only an internal function.
  */
-static struct tld_file * g_tld_file = nullptr;
+static struct tld_context g_tld_context = { nullptr, { 0, nullptr }, nullptr };
 
 
 
@@ -347,58 +449,160 @@ namespace
 
 
 
-/** \brief Convert tags to tld_info fields.
+/** \brief Search the category and country tags of a description.
  *
  * The old tld_info offered a category field and a country field. To keep
- * the legacy setup we have this function going through the tags an
+ * the legacy setup we have this function going through the tags and
  * extracting the tag named "category" and the tag named "country" when
  * they exist.
  *
+ * \param[in] file  The file the \p tld description comes from.
  * \param[in] tld  The tld description with the list of tags.
- * \param[in] info  The info structure where the strings are copied.
+ * \param[out] desc_info  The category and country found in the tags.
  */
-void tags_to_info(const struct tld_description *tld, struct tld_info *info)
+void tags_to_description_info(struct tld_file const * file, const struct tld_description *tld, struct tld_description_info *desc_info)
 {
     tld_tag const * tag;
     uint32_t l;
     char const * str;
+
+    desc_info->f_category = TLD_CATEGORY_UNDEFINED;
+    desc_info->f_country = 0;
     for(uint32_t idx(0); idx < tld->f_tags_count; ++idx)
     {
-        tag = tld_file_tag(g_tld_file, tld->f_tags + idx * 2);
-        if(tag == nullptr)
-        {
-            continue;
-        }
-
-        str = tld_file_string(g_tld_file, tag->f_tag_name, &l);
-        if(str == nullptr)
-        {
-            continue;
-        }
+        tag = tld_file_tag_unchecked(file, tld->f_tags + idx * 2);
+        str = tld_file_string_unchecked(file, tag->f_tag_name, &l);
         if(l == 8
         && memcmp(str, "category", l) == 0)
         {
-            str = tld_file_string(g_tld_file, tag->f_tag_value, &l);
-            if(str != nullptr)
-            {
-                info->f_category = tld_word_to_category(str, l);
-            }
+            str = tld_file_string_unchecked(file, tag->f_tag_value, &l);
+            desc_info->f_category = tld_word_to_category(str, l);
         }
         else if(l == 7
              && memcmp(str, "country", l) == 0)
         {
-            str = tld_file_string(g_tld_file, tag->f_tag_value, &l);
-            if(str != nullptr
-            && l < sizeof(info->f_country))
+            tld_file_string_unchecked(file, tag->f_tag_value, &l);
+            if(l < sizeof(tld_info::f_country))
             {
-                memcpy(info->f_country, str, l);
-                info->f_country[l] = '\0'; // the tld_clear_info() already does that -- double safe
+                desc_info->f_country = tag->f_tag_value;
             }
         }
     }
 }
 
 
+/** \brief Get the category and country of a TLD description.
+ *
+ * The category and country are resolved when the TLDs get loaded so
+ * this function does not have to search the tags. If that information
+ * could not be allocated, the tags are searched each time and the
+ * result is saved in \p buffer.
+ *
+ * \param[in] context  The context the \p tld description comes from.
+ * \param[in] tld  The tld description with the list of tags.
+ * \param[out] buffer  A buffer used when the tags need to be searched.
+ *
+ * \return A pointer to the description info of \p tld.
+ */
+static struct tld_description_info const * get_description_info(struct tld_context const * context, const struct tld_description *tld, struct tld_description_info *buffer)
+{
+    if(context->f_description_infos != nullptr)
+    {
+        return context->f_description_infos + (tld - context->f_file->f_descriptions);
+    }
+
+    tags_to_description_info(context->f_file, tld, buffer);
+    return buffer;
+}
+
+
+/** \brief Convert tags to tld_info fields.
+ *
+ * This function sets the category and country fields of \p info from
+ * the tags of the \p tld description. The \p info structure is expected
+ * to have been cleared with tld_clear_info().
+ *
+ * \param[in] context  The context the \p tld description comes from.
+ * \param[in] tld  The tld description with the list of tags.
+ * \param[in] info  The info structure where the strings are copied.
+ */
+void tags_to_info(struct tld_context const * context, const struct tld_description *tld, struct tld_info *info)
+{
+    struct tld_description_info desc_info;
+    struct tld_description_info const * d;
+    uint32_t l;
+    char const * str;
+
+    d = get_description_info(context, tld, &desc_info);
+    info->f_category = static_cast<tld_category>(d->f_category);
+    if(d->f_country != 0)
+    {
+        str = tld_file_string_unchecked(context->f_file, d->f_country, &l);
+        memcpy(info->f_country, str, l);
+        info->f_country[l] = '\0'; // the tld_clear_info() already does that -- double safe
+    }
+}
+
+
+/** \brief Convert tags to tld_info_lite fields.
+ *
+ * This function sets the category and/or country fields of \p info
+ * as selected by \p fields. The country is not copied. Instead the
+ * f_country pointer is set to the string found in the TLDs.
+ *
+ * \param[in] context  The context the \p tld description comes from.
+ * \param[in] tld  The tld description with the list of tags.
+ * \param[in] info  The info structure to update.
+ * \param[in] fields  The TLD_INFO_... fields to set.
+ */
+static void tags_to_info_lite(struct tld_context const * context, const struct tld_description *tld, struct tld_info_lite *info, int fields)
+{
+    struct tld_description_info desc_info;
+    struct tld_description_info const * d;
+    uint32_t l;
+
+    if((fields & TLD_INFO_ALL) == 0)
+    {
+        return;
+    }
+
+    d = get_description_info(context, tld, &desc_info);
+    if((fields & TLD_INFO_CATEGORY) != 0)
+    {
+        info->f_category = static_cast<tld_category>(d->f_category);
+    }
+    if((fields & TLD_INFO_COUNTRY) != 0
+    && d->f_country != 0)
+    {
+        info->f_country = tld_file_string_unchecked(context->f_file, d->f_country, &l);
+        info->f_country_length = static_cast<int>(l);
+    }
+}
+
+
+/** \brief Copy a tld_info_lite in a tld_info structure.
+ *
+ * This function copies the fields of \p lite to \p info. The country
+ * name gets copied in the tld_info::f_country buffer. The \p info
+ * structure is expected to have been cleared with tld_clear_info().
+ *
+ * \param[in] lite  The tld_info_lite structure to copy.
+ * \param[out] info  The tld_info structure to set.
+ */
+static void lite_to_info(struct tld_info_lite const * lite, struct tld_info *info)
+{
+    info->f_category = lite->f_category;
+    info->f_status = lite->f_status;
+    if(lite->f_country != nullptr)
+    {
+        memcpy(info->f_country, lite->f_country, lite->f_country_length);
+    }
+    info->f_tld = lite->f_tld;
+    info->f_offset = lite->f_offset;
+    info->f_tld_index = lite->f_tld_index;
+}
+
+
 /** \brief Check whether a character is a hexadecimal character.
  *
  * This internal function returns true if the input character represents
@@ -439,29 +643,164 @@ int h2d(int c)
 }
 
 
+/** \brief The classes of the characters found in a URI.
+ *
+ * The tld_check_uri() function uses these classes to determine which
+ * characters need special handling. The g_uri_class table gives the
+ * classes of each one of the 256 possible bytes.
+ */
+int const URI_CLASS_CONTROL  = 0x01;    // 0x00 to 0x1F
+int const URI_CLASS_SPACE    = 0x02;    // ' ' and '+'
+int const URI_CLASS_HIGH     = 0x04;    // 0x80 to 0xFF
+int const URI_CLASS_QUERY    = 0x08;    // '?', '&', '=', and '#'
+int const URI_CLASS_PERCENT  = 0x10;    // '%'
+int const URI_CLASS_HOST     = 0x20;    // '@', ':', '.', and '/'
+int const URI_CLASS_PROTOCOL = 0x40;    // [0-9A-Za-z_]
+int const URI_CLASS_HEX      = 0x80;    // [0-9A-Fa-f]
+
+
+/** \brief The class of each byte.
+ *
+ * See the URI_CLASS_... values for details.
+ */
+unsigned char const g_uri_class[256] =
+{
+    /* 0x00 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    /* 0x10 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    /* 0x20 */ 0x02, 0x00, 0x00, 0x08, 0x00, 0x10, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x20, 0x20,
+    /* 0x30 */ 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0x20, 0x00, 0x00, 0x08, 0x00, 0x08,
+    /* 0x40 */ 0x20, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    /* 0x50 */ 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x40,
+    /* 0x60 */ 0x00, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    /* 0x70 */ 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0x80 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    /* 0x90 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    /* 0xA0 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    /* 0xB0 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    /* 0xC0 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    /* 0xD0 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    /* 0xE0 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    /* 0xF0 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+};
+
+
+/** \brief Skip the URI characters which do not require special handling.
+ *
+ * This function returns a pointer to the first character between \p s
+ * and \p end which has one of the \p stop classes. If no such character
+ * is found, the function returns \p end.
+ *
+ * The path and query string of a URI are often very long (i.e. tracking
+ * parameters) and only include a few characters that require special
+ * handling. When SSE2 is available, this function checks 16 characters
+ * at a time.
+ *
+ * \note
+ * With SSE2, the URI_CLASS_PROTOCOL and URI_CLASS_HEX classes are not
+ * supported in \p stop.
+ *
+ * \param[in] s  The first character to check.
+ * \param[in] end  The end of the URI (exclusive).
+ * \param[in] stop  The URI_CLASS_... of the characters to stop at.
+ *
+ * \return A pointer to the first character to be handled or \p end.
+ */
+char const * skip_uri_characters(char const * s, char const * end, int stop)
+{
+#ifdef __SSE2__
+    if(end - s >= 16)
+    {
+        __m128i const control(_mm_set1_epi8(0x1F));
+        __m128i const zero(_mm_setzero_si128());
+        do
+        {
+            __m128i const v(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s)));
+            __m128i m(zero);
+            if((stop & URI_CLASS_CONTROL) != 0)
+            {
+                m = _mm_cmpeq_epi8(_mm_min_epu8(v, control), v);
+            }
+            if((stop & URI_CLASS_SPACE) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('+')));
+            }
+            if((stop & URI_CLASS_HIGH) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmplt_epi8(v, zero));
+            }
+            if((stop & URI_CLASS_QUERY) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('?')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('&')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('=')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('#')));
+            }
+            if((stop & URI_CLASS_PERCENT) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('%')));
+            }
+            if((stop & URI_CLASS_HOST) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('@')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+            }
+            int const mask(_mm_movemask_epi8(m));
+            if(mask != 0)
+            {
+                return s + __builtin_ctz(mask);
+            }
+            s += 16;
+        }
+        while(end - s >= 16);
+    }
+#endif
+
+    for(; s < end && (g_uri_class[static_cast<unsigned char>(*s)] & stop) == 0; ++s);
+
+    return s;
+}
+
+
 
 } // no name namespace
 
 
 
-/** \brief Load the TLDs if not yet loaded.
+/** \brief Make sure a context is ready to be searched.
  *
  * This user can call the tld_load_tlds() function to load or reload
  * the TLDs from a file the user chooses.
  *
  * However, if one of the functions, such as tld(), gets called before
  * the TLDs are loaded, it would crash since the pointer is still nullptr.
- * Instead, these functions call the tld_load_tlds_if_not_loaded() function
- * to make sure that the g_tld_file is not a null pointer anymore.
+ * Instead, these functions call the context_ready() function to make
+ * sure that the default context f_file is not a null pointer anymore.
  *
- * \return The result of loading, TLD_RESULT_SUCCESS if the g_tld_file
- * is not a nullptr.
+ * A context created with tld_context_load() always has a file so it
+ * never gets loaded here.
+ *
+ * \param[in] context  The context to check.
+ *
+ * \return The result of loading, TLD_RESULT_SUCCESS if the context f_file
+ * is not a nullptr, TLD_RESULT_NULL if \p context is a null pointer.
  */
-static enum tld_result tld_load_tlds_if_not_loaded()
+static enum tld_result context_ready(struct tld_context const * context)
 {
-    if(g_tld_file == nullptr)
+    if(context == nullptr)
+    {
+        return TLD_RESULT_NULL;
+    }
+
+    if(context->f_file == nullptr)
     {
-        return tld_load_tlds(nullptr, 1);
+        if(context == &g_tld_context)
+        {
+            return tld_load_tlds(nullptr, 1);
+        }
+        return TLD_RESULT_INVALID;
     }
 
     return TLD_RESULT_SUCCESS;
@@ -559,6 +898,11 @@ static int cmp(const char *a, int l, const char *b, int n)
  *
  * When the TLD cannot be found, the function returns -1.
  *
+ * The context must already be loaded (see context_ready()). The indexes
+ * found in the descriptions were verified when the file was loaded so
+ * this function does not check them again.
+ *
+ * \param[in] context  The context with the TLDs to search.
  * \param[in] i  The start point of the search (included.)
  * \param[in] j  The end point of the search (excluded.)
  * \param[in] domain  The domain name to search.
@@ -566,19 +910,12 @@ static int cmp(const char *a, int l, const char *b, int n)
  *
  * \return The offset of the domain found, or -1 when not found.
  */
-static int search(int i, int j, char const * domain, int n)
+static int search(struct tld_context const * context, int i, int j, char const * domain, int n)
 {
     int auto_match = -1, p, r;
     uint32_t l;
     struct tld_description const * tld;
     char const * name;
-    enum tld_result result;
-
-    result = tld_load_tlds_if_not_loaded();
-    if(result != TLD_RESULT_SUCCESS)
-    {
-        return -1;
-    }
 
 #ifdef _DEBUG
     if(static_cast<uint32_t>(i) > static_cast<uint32_t>(j))
@@ -599,8 +936,8 @@ static int search(int i, int j, char const * domain, int n)
     if(i < j)
     {
 #ifdef _DEBUG
-        if(static_cast<uint32_t>(i) >= g_tld_file->f_descriptions_count
-        || static_cast<uint32_t>(j) > g_tld_file->f_descriptions_count) // can be equal to max. (actually it should always be on first call)
+        if(static_cast<uint32_t>(i) >= context->f_file->f_descriptions_count
+        || static_cast<uint32_t>(j) > context->f_file->f_descriptions_count) // can be equal to max. (actually it should always be on first call)
         {
             // LCOV_EXCL_START
             std::cerr
@@ -609,7 +946,7 @@ static int search(int i, int j, char const * domain, int n)
                 << ") or j ("
                 << j
                 << ") is too large, max is "
-                << g_tld_file->f_descriptions_count
+                << context->f_file->f_descriptions_count
                 << '.'
                 << std::endl;
             std::terminate();
@@ -618,16 +955,8 @@ static int search(int i, int j, char const * domain, int n)
 #endif
 
         /* the "*" breaks the binary search, we have to handle it specially */
-        tld = tld_file_description(g_tld_file, i);
-        if(tld == nullptr)
-        {
-            return -1;      // LCOV_EXCL_LINE -- see above (already checked)
-        }
-        name = tld_file_string(g_tld_file, tld->f_tld, &l);
-        if(name == nullptr)
-        {
-            return -1;      // LCOV_EXCL_LINE -- see above (already checked)
-        }
+        tld = tld_file_description_unchecked(context->f_file, i);
+        name = tld_file_string_unchecked(context->f_file, tld->f_tld, &l);
         if(l == 1 && name[0] == '*')
         {
             auto_match = i;
@@ -637,16 +966,8 @@ static int search(int i, int j, char const * domain, int n)
         while(i < j)
         {
             p = (j - i) / 2 + i;
-            tld = tld_file_description(g_tld_file, p);
-            if(tld == nullptr)
-            {
-                return -1;
-            }
-            name = tld_file_string(g_tld_file, tld->f_tld, &l);
-            if(name == nullptr)
-            {
-                return -1;
-            }
+            tld = tld_file_description_unchecked(context->f_file, p);
+            name = tld_file_string_unchecked(context->f_file, tld->f_tld, &l);
 #if 0
 std::cerr << "--- name offset: " << tld->f_tld << " --- ptr: " << reinterpret_cast<void const *>(name) << ", cmp(\"" << std::string(name, l) << "\", \"" << std::string(domain, n) << "\") == " << r << "\n";
 #endif
@@ -688,119 +1009,1351 @@ std::cerr << "--- name offset: " << tld->f_tld << " --- cmp(\"" << std::string(n
 }
 
 
-/** \brief Clear the info structure.
+/** \brief Compute the hash of a TLD name within a level.
+ * \internal
  *
- * This function initializes the info structure with defaults.
- * The different TLD functions that make use of this structure
- * will generally call this function first to represent a
- * failure case.
+ * This function computes an FNV-1a hash of the level start offset and
+ * the \p n characters of \p name.
  *
- * Note that by default the category and status are set to
- * undefined (TLD_CATEGORY_UNDEFINED and TLD_STATUS_UNDEFINED).
- * Also the country and tld pointer are set to NULL and thus
- * they cannot be used as strings.
+ * \param[in] start  The start offset of the level.
+ * \param[in] name  The name to hash.
+ * \param[in] n  The number of characters in \p name.
  *
- * \param[out] info  The tld_info structure to clear.
+ * \return The 32 bit hash.
  */
-void tld_clear_info(struct tld_info *info)
+static uint32_t hash_name(int start, char const * name, int n)
 {
-    info->f_category = TLD_CATEGORY_UNDEFINED;
-    info->f_status = TLD_STATUS_UNDEFINED;
-    memset(info->f_country, 0, sizeof(info->f_country));
-    info->f_tld = (const char *) 0;
-    info->f_offset = -1;
-    info->f_tld_index = -1;
+    uint32_t h(2166136261U);
+    h = (h ^ static_cast<uint32_t>(start)) * 16777619U;
+    for(int idx(0); idx < n; ++idx)
+    {
+        h = (h ^ static_cast<unsigned char>(name[idx])) * 16777619U;
+    }
+    return h;
 }
 
 
-/** \brief Load a TLDs file as the file to be used by the tld() function.
- *
- * This function loads the specified \p filename as the current set of
- * data to be used by the tld() function.
+/** \brief Release the hash index.
+ * \internal
  *
- * You generally do not need to call this function, instead, it will be
- * automatically called with a null pointer which will load the default
- * file as expected.
+ * This function releases the hash index of the TLD file of \p context.
+ * It gets called whenever the TLD file itself gets released.
  *
- * The \p fallback flag can be set to true (the default) to fallback to
- * the static version of the data compiled internally. This is used if
- * the specified or default external file cannot be loaded.
+ * \param[in,out] context  The context of which the hash index is released.
+ */
+static void free_hash_index(struct tld_context * context)
+{
+    free(context->f_hash_index.f_slots);
+    context->f_hash_index.f_slots = nullptr;
+    context->f_hash_index.f_mask = 0;
+}
+
+
+/** \brief Add the TLDs of one level to the hash index.
+ * \internal
  *
- * \warning
- * You can call this function at any time to switch between .tld files.
- * However, any structure loaded with this function prior to a call to
- * this function must all be considered invalid since some string
- * pointers in those structures may still point in the old buffer.
+ * This function adds all the TLDs found in [start, end) to the hash
+ * index. If the same level is referenced by multiple descriptions, it
+ * gets added only once.
  *
- * \param[in] filename  The file to load or NULL to load the default.
- * \param[in] fallback  Whether to fallback to the internal data if the
- * input file cannot be loaded.
+ * \param[in,out] context  The context of which the hash index is built.
+ * \param[in] start  The first description of the level.
+ * \param[in] end  The description just after the last one of the level.
+ * \param[in,out] used  The number of slots used so far.
  *
- * \return A tld_result representing the success or failure:
- * TLD_RESULT_SUCCESS for success, TLD_RESULT_INVALID for errors where
- * the file could not be read, and TLD_RESULT_NOT_FOUND if the file is
- * not found.
+ * \return false if the table is too small to add all the TLDs.
  */
-enum tld_result tld_load_tlds(char const * filename, int fallback)
+static bool add_level_to_hash_index(struct tld_context * context, int start, int end, uint32_t & used)
 {
-    enum tld_file_error err;
-
-    tld_file_free(&g_tld_file);
-
-    if(filename == nullptr)
+    for(int idx(start); idx < end; ++idx)
     {
-        // first try a user updated version of the file
-        //
-        err = tld_file_load("/var/lib/libtld/tlds.tld", &g_tld_file);
-        if(err == TLD_FILE_ERROR_NONE)
+        tld_description const * tld(tld_file_description(context->f_file, idx));
+        if(tld == nullptr)
         {
-            return TLD_RESULT_SUCCESS;
+            return false;
         }
-        // else -- ignore any other error
-
-        // second try the default installed version of the file
-        //
-        filename = "/usr/share/libtld/tlds.tld";
-    }
-    // else -- only try with the user defined version
-
-    err = tld_file_load(filename, &g_tld_file);
-    if(err == TLD_FILE_ERROR_NONE)
-    {
-        return TLD_RESULT_SUCCESS;
-    }
-
-    if(fallback != 0)
-    {
-        // use the descriptions from tld_data.c as fallback
-        //
-        std::stringstream in;
-        in.write(reinterpret_cast<char const *>(tld_static_tlds), tld_get_static_tlds_buffer_size());
-        err = tld_file_load_stream(&g_tld_file, in);
-        if(err == TLD_FILE_ERROR_NONE)
+        uint32_t l;
+        char const * name(tld_file_string(context->f_file, tld->f_tld, &l));
+        if(name == nullptr)
         {
-            return TLD_RESULT_SUCCESS;
+            continue;
+        }
+        uint32_t const h(hash_name(start, name, l));
+        uint32_t const slot((h & 0xFFFF0000) | static_cast<uint32_t>(idx + 1));
+        for(uint32_t pos(h & context->f_hash_index.f_mask);; pos = (pos + 1) & context->f_hash_index.f_mask)
+        {
+            if(context->f_hash_index.f_slots[pos] == 0)
+            {
+                // keep at least one empty slot so searches end
+                //
+                ++used;
+                if(used > context->f_hash_index.f_mask)
+                {
+                    return false;
+                }
+                context->f_hash_index.f_slots[pos] = slot;
+                break;
+            }
+            if(context->f_hash_index.f_slots[pos] == slot)
+            {
+                // level shared by several descriptions
+                //
+                break;
+            }
         }
     }
 
-    return err == TLD_FILE_ERROR_CANNOT_OPEN_FILE
-                ? TLD_RESULT_NOT_FOUND
-                : TLD_RESULT_INVALID;
+    return true;
 }
 
 
-/** \brief Return a pointer to the current list of TLDs.
+/** \brief Build the hash index of the current TLD file.
+ * \internal
  *
- * This function returns the list of TLDs that were loaded by the
- * tld_load_tlds() function. If the TLDs were not yet loaded, then
- * the function returns a nullptr.
+ * This function builds the hash index of \p context from the context
+ * file descriptions. The table is sized to be at most half full so the
+ * number of probes remains very small.
  *
- * The structure must be considered 100% read-only. It is possible that
- * the TLDs were loaded from the tld_data.c buffer which means it is
- * read-only data from the library.
+ * If the table cannot be allocated, the function silently returns and
+ * the lookups use the search() function instead.
  *
- * \warning
- * Calling the tld_free_tlds() invalidates the pointer returned by this
+ * \param[in,out] context  The context of which the hash index is built.
+ */
+static void build_hash_index(struct tld_context * context)
+{
+    free_hash_index(context);
+
+    uint32_t const count(context->f_file->f_descriptions_count);
+    if(count == 0
+    || count >= USHRT_MAX)
+    {
+        return;
+    }
+
+    uint32_t size(1);
+    while(size < count * 2)
+    {
+        size <<= 1;
+    }
+    context->f_hash_index.f_slots = static_cast<uint32_t *>(calloc(size, sizeof(uint32_t)));
+    if(context->f_hash_index.f_slots == nullptr)
+    {
+        return;
+    }
+    context->f_hash_index.f_mask = size - 1;
+
+    uint32_t used(0);
+    bool valid(add_level_to_hash_index(context,
+              context->f_file->f_header->f_tld_start_offset
+            , context->f_file->f_header->f_tld_end_offset
+            , used));
+    for(uint32_t idx(0); valid && idx < count; ++idx)
+    {
+        tld_description const * tld(context->f_file->f_descriptions + idx);
+        if(tld->f_start_offset != USHRT_MAX)
+        {
+            valid = add_level_to_hash_index(context, tld->f_start_offset, tld->f_end_offset, used);
+        }
+    }
+    if(!valid)
+    {
+        free_hash_index(context);
+    }
+}
+
+
+/** \brief Release the tld_info fields of the descriptions.
+ * \internal
+ *
+ * \param[in,out] context  The context with the array to release.
+ */
+static void free_description_infos(struct tld_context * context)
+{
+    free(context->f_description_infos);
+    context->f_description_infos = nullptr;
+}
+
+
+/** \brief Resolve the tld_info fields of all the descriptions.
+ * \internal
+ *
+ * This function searches the category and country tags of each
+ * description once so the tags_to_info() function does not have to.
+ *
+ * If the array cannot be allocated, f_description_infos remains a null
+ * pointer and tags_to_info() searches the tags instead.
+ *
+ * \param[in,out] context  The context with the descriptions.
+ */
+static void build_description_infos(struct tld_context * context)
+{
+    free_description_infos(context);
+
+    uint32_t const count(context->f_file->f_descriptions_count);
+    context->f_description_infos = static_cast<struct tld_description_info *>(malloc((count + 1) * sizeof(struct tld_description_info)));
+    if(context->f_description_infos == nullptr)
+    {
+        return;
+    }
+
+    for(uint32_t idx(0); idx < count; ++idx)
+    {
+        tags_to_description_info(context->f_file, context->f_file->f_descriptions + idx, context->f_description_infos + idx);
+    }
+}
+
+
+/** \brief Build all the indexes of a context.
+ * \internal
+ *
+ * This function is called each time a TLD file gets loaded in a context.
+ *
+ * \param[in,out] context  The context with the newly loaded TLDs.
+ */
+static void build_indexes(struct tld_context * context)
+{
+    build_hash_index(context);
+    build_description_infos(context);
+}
+
+
+/** \brief Release all the indexes of a context.
+ * \internal
+ *
+ * \param[in,out] context  The context with the indexes to release.
+ */
+static void free_indexes(struct tld_context * context)
+{
+    free_hash_index(context);
+    free_description_infos(context);
+}
+
+
+/** \brief Search for the specified domain using the hash index.
+ * \internal
+ *
+ * This function returns the exact same result as the search() function.
+ * It makes use of the hash index instead of a binary search so it
+ * only needs one or two probes in the table.
+ *
+ * If the hash index is not available, then the function calls search().
+ *
+ * \param[in] context  The context with the TLDs to search.
+ * \param[in] i  The start point of the search (included.)
+ * \param[in] j  The end point of the search (excluded.)
+ * \param[in] domain  The domain name to search.
+ * \param[in] n  The length of the domain name.
+ *
+ * \return The offset of the domain found, or -1 when not found.
+ */
+static int hash_search(struct tld_context const * context, int i, int j, char const * domain, int n)
+{
+    if(context->f_hash_index.f_slots == nullptr)
+    {
+        return search(context, i, j, domain, n);
+    }
+
+    if(i >= j)
+    {
+        return -1;
+    }
+
+    uint32_t const h(hash_name(i, domain, n));
+    uint32_t const tag(h & 0xFFFF0000);
+    for(uint32_t pos(h & context->f_hash_index.f_mask);; pos = (pos + 1) & context->f_hash_index.f_mask)
+    {
+        uint32_t const slot(context->f_hash_index.f_slots[pos]);
+        if(slot == 0)
+        {
+            break;
+        }
+        if((slot & 0xFFFF0000) == tag)
+        {
+            int const p(static_cast<int>(slot & 0xFFFF) - 1);
+            if(p >= i && p < j)
+            {
+                uint32_t l;
+                char const * name(tld_file_string_unchecked(context->f_file, context->f_file->f_descriptions[p].f_tld, &l));
+                if(static_cast<int>(l) == n
+                && memcmp(name, domain, n) == 0)
+                {
+                    return p;
+                }
+            }
+        }
+    }
+
+    /* the "*" matches anything that was not otherwise found */
+    uint32_t l;
+    char const * name(tld_file_string_unchecked(context->f_file, context->f_file->f_descriptions[i].f_tld, &l));
+    if(l == 1
+    && name[0] == '*')
+    {
+        return i;
+    }
+
+    return -1;
+}
+
+
+/** \brief Find the periods of the last levels of a domain name.
+ * \internal
+ *
+ * This function searches the domain name from the end toward the start
+ * for up to \p max_level periods. Only the last \p max_level labels of
+ * a domain name can be part of a TLD so there is no need to look at
+ * the sub-domains in any details. This allows the tld() function to
+ * work without any heap allocation and without shifting an array of
+ * pointers each time a period is found in long sub-domain chains.
+ *
+ * The pointers are saved at the end of the \p level_ptr array. The
+ * first pointer is found at `level_ptr + max_level - level` where
+ * `level` is the value returned by this function. That way the pointers
+ * appear in the same order as in the domain name (left to right).
+ *
+ * When the domain name has more periods than \p max_level, the rest of
+ * the domain name is still checked for two periods one after another
+ * to detect invalid domain names.
+ *
+ * \param[in] uri  The start of the domain name.
+ * \param[in] end  The end of the domain name (exclusive).
+ * \param[in] max_level  The maximum number of periods to search.
+ * \param[out] level_ptr  An array of at least \p max_level pointers.
+ *
+ * \return The number of periods found (at most \p max_level) or -1 if
+ * two periods one after another were found.
+ */
+static int split_levels(char const * uri, char const * end, int max_level, char const ** level_ptr)
+{
+    int level(0);
+    char const * s(end);
+    while(s > uri && level < max_level)
+    {
+        --s;
+        if(*s == '.')
+        {
+            if(level > 0 && s + 1 == level_ptr[max_level - level])
+            {
+                /* two periods one after another */
+                return -1;
+            }
+            ++level;
+            level_ptr[max_level - level] = s;
+        }
+    }
+
+    if(level > 0 && level == max_level)
+    {
+        // the sub-domains are not otherwise used, but we still want
+        // to detect two periods one after another
+        //
+        for(char const * p(static_cast<char const *>(memchr(uri, '.', s - uri)));
+            p != nullptr;
+            p = static_cast<char const *>(memchr(p + 1, '.', s - p - 1)))
+        {
+            if(p[1] == '.')
+            {
+                /* two periods one after another */
+                return -1;
+            }
+        }
+    }
+
+    return level;
+}
+
+
+/** \brief Find the start of the label following a period.
+ * \internal
+ *
+ * The periods found by the tld_check_uri() function may be encoded
+ * as "%2E". In that case the label starts three characters further.
+ *
+ * \param[in] period  A pointer to a '.' or the '%' of a "%2E".
+ *
+ * \return A pointer to the first character of the label.
+ */
+static inline char const * label_start(char const * period)
+{
+    return period + (*period == '.' ? 1 : 3);
+}
+
+
+/** \brief Search one label, percent-decoding it when required.
+ * \internal
+ *
+ * This function calls hash_search() with the label defined between
+ * \p start and \p end. When \p decode is not zero and the label
+ * includes \%XX sequences, the label gets decoded in a small buffer
+ * first. A label which is too long for that buffer cannot match a TLD
+ * so in that case the function returns -1 without searching.
+ *
+ * \param[in] context  The context with the TLDs.
+ * \param[in] i  The start of the descriptions to search.
+ * \param[in] j  The end of the descriptions to search (exclusive).
+ * \param[in] start  The start of the label.
+ * \param[in] end  The end of the label (exclusive).
+ * \param[in] decode  Whether \%XX sequences need to be decoded.
+ *
+ * \return The index of the TLD found or -1.
+ */
+static int label_search(struct tld_context const * context, int i, int j, char const * start, char const * end, int decode)
+{
+    char label[256];
+    int n;
+
+    if(decode == 0
+    || memchr(start, '%', end - start) == nullptr)
+    {
+        return hash_search(context, i, j, start, static_cast<int>(end - start));
+    }
+
+    for(n = 0; start < end; ++n, ++start)
+    {
+        if(n >= static_cast<int>(sizeof(label)))
+        {
+            return -1;
+        }
+        if(*start == '%')
+        {
+            label[n] = static_cast<char>(h2d(start[1]) * 16 + h2d(start[2]));
+            start += 2;
+        }
+        else
+        {
+            label[n] = *start;
+        }
+    }
+
+    return hash_search(context, i, j, label, n);
+}
+
+
+/** \brief Search the TLD of a domain name already split in levels.
+ * \internal
+ *
+ * This function does the actual TLD search of the tld_ctx_n() and
+ * tld_ctx_check_uri_n() functions once the periods of the last levels
+ * of the domain name were found. The domain name itself is not scanned
+ * again, only the labels defined by \p level_ptr get searched.
+ *
+ * The \p level_ptr pointers point to the periods in the same order as
+ * in the domain name (left to right). When \p decode is not zero, a
+ * period may also be encoded as "%2E" and the labels get percent-decoded
+ * before they are searched.
+ *
+ * The context must already be loaded.
+ *
+ * \param[in] context  The context with the TLDs.
+ * \param[in] uri  The start of the domain name.
+ * \param[in] end  The end of the domain name (exclusive).
+ * \param[in] level_ptr  The pointers to the last \p level periods.
+ * \param[in] level  The number of pointers in \p level_ptr.
+ * \param[in] decode  Whether the domain name may include \%XX sequences.
+ * \param[out] info  The tld_info_lite structure to set.
+ * \param[in] fields  The TLD_INFO_... fields to set in \p info.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ */
+static enum tld_result search_levels(struct tld_context const * context, char const * uri, char const * end, char const * const * level_ptr, int level, int decode, struct tld_info_lite * info, int fields)
+{
+    struct tld_description const * tld;
+    int start_level, r, p, offset;
+    enum tld_result result;
+
+    /* if level is not at least 1 then there are no periods */
+    if(level == 0)
+    {
+        /* no TLD */
+        return TLD_RESULT_NO_TLD;
+    }
+
+    start_level = level;
+    --level;
+    r = label_search(context, context->f_file->f_header->f_tld_start_offset,
+                context->f_file->f_header->f_tld_end_offset,
+                label_start(level_ptr[level]), end, decode);
+    if(r == -1)
+    {
+        /* unknown */
+        return TLD_RESULT_NOT_FOUND;
+    }
+
+    /* check for the next level if there is one */
+    for(p = r; level > 0; --level, p = r)
+    {
+        tld = tld_file_description_unchecked(context->f_file, r);
+        if(tld->f_start_offset == USHRT_MAX)
+        {
+            break;
+        }
+        r = label_search(context, tld->f_start_offset, tld->f_end_offset,
+                label_start(level_ptr[level - 1]), level_ptr[level], decode);
+        if(r == -1)
+        {
+            /* we are done, return the previous level */
+            break;
+        }
+    }
+    offset = (int) (level_ptr[level] - uri);
+
+    /* if there are exceptions we may need to search those now if level is 0 */
+    if(level == 0)
+    {
+        tld = tld_file_description_unchecked(context->f_file, p);
+        r = label_search(context, tld->f_start_offset,
+                tld->f_end_offset,
+                uri, level_ptr[0], decode);
+        if(r != -1)
+        {
+            p = r;
+            offset = 0;
+        }
+    }
+
+    tld = tld_file_description_unchecked(context->f_file, p);
+    info->f_status = static_cast<tld_status>(tld->f_status);
+    info->f_tld_index = p;
+    switch(info->f_status)
+    {
+    case TLD_STATUS_VALID:
+        result = TLD_RESULT_SUCCESS;
+        break;
+
+    case TLD_STATUS_EXCEPTION:
+        /* return the actual TLD and not the exception
+         * i.e. "nacion.ar" is valid and the TLD is just ".ar"
+         * even though top level ".ar" is forbidden by default
+         */
+        p = tld->f_exception_apply_to;
+        tld = tld_file_description_unchecked(context->f_file, p);
+        level = start_level - tld->f_exception_level;
+        offset = static_cast<int>(level_ptr[level] - uri);
+        info->f_status = TLD_STATUS_VALID;
+        result = TLD_RESULT_SUCCESS;
+        break;
+
+    default:
+        result = TLD_RESULT_INVALID;
+        break;
+
+    }
+
+    tags_to_info_lite(context, tld, info, fields);
+
+    info->f_tld = level_ptr[level];
+    info->f_offset = offset;
+
+    return result;
+}
+
+
+/** \brief Search one label ignoring case.
+ * \internal
+ *
+ * The labels of DNS queries often include uppercase characters (resolvers
+ * randomize the case of the names they send). This function searches
+ * the lowercase version of the label. The label only gets copied when
+ * it includes uppercase characters.
+ *
+ * \param[in] context  The context with the TLDs.
+ * \param[in] i  The start point of the search (included.)
+ * \param[in] j  The end point of the search (excluded.)
+ * \param[in] start  The start of the label.
+ * \param[in] n  The length of the label.
+ *
+ * \return The offset of the label found, or -1 when not found.
+ */
+static int label_search_lower(struct tld_context const * context, int i, int j, char const * start, int n)
+{
+    char label[256];
+    int k;
+
+    for(k = 0; k < n && (start[k] < 'A' || start[k] > 'Z'); ++k);
+    if(k == n)
+    {
+        return hash_search(context, i, j, start, n);
+    }
+    if(n > static_cast<int>(sizeof(label)))
+    {
+        return -1;
+    }
+
+    memcpy(label, start, k);
+    for(; k < n; ++k)
+    {
+        label[k] = start[k] >= 'A' && start[k] <= 'Z'
+                        ? static_cast<char>(start[k] | 0x20)
+                        : start[k];
+    }
+
+    return hash_search(context, i, j, label, n);
+}
+
+
+/** \brief Search the TLD of a domain name already split in labels.
+ * \internal
+ *
+ * This function applies the same rules as search_levels() to an array
+ * of labels. The labels are in the same order as in the domain name
+ * (left to right) and only the last ones get searched.
+ *
+ * On return the tld_info_lite::f_offset field is set to the index of
+ * the first label of the TLD and tld_info_lite::f_tld points to that
+ * label. Index 0 means that the whole name is a TLD.
+ *
+ * The context must already be loaded and the labels must not be empty.
+ *
+ * \param[in] context  The context with the TLDs.
+ * \param[in] labels  The labels of the domain name.
+ * \param[in] count  The number of labels.
+ * \param[out] info  The tld_info_lite structure to set.
+ * \param[in] fields  The TLD_INFO_... fields to set in \p info.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ */
+static enum tld_result search_labels(struct tld_context const * context, struct tld_label const * labels, int count, struct tld_info_lite * info, int fields)
+{
+    struct tld_description const * tld;
+    int first, k, r, p, idx;
+    enum tld_result result;
+
+    /* at least two labels are necessary (i.e. one period) */
+    if(count < 2)
+    {
+        /* no TLD */
+        return TLD_RESULT_NO_TLD;
+    }
+
+    /* only the last max_level labels can be part of the TLD */
+    first = count - static_cast<int>(context->f_file->f_header->f_tld_max_level);
+    if(first < 1)
+    {
+        first = 1;
+    }
+
+    k = count - 1;
+    r = label_search_lower(context, context->f_file->f_header->f_tld_start_offset,
+                context->f_file->f_header->f_tld_end_offset,
+                labels[k].f_label, labels[k].f_length);
+    if(r == -1)
+    {
+        /* unknown */
+        return TLD_RESULT_NOT_FOUND;
+    }
+
+    /* check for the next level if there is one */
+    for(p = r; k > first; --k, p = r)
+    {
+        tld = tld_file_description_unchecked(context->f_file, r);
+        if(tld->f_start_offset == USHRT_MAX)
+        {
+            break;
+        }
+        r = label_search_lower(context, tld->f_start_offset, tld->f_end_offset,
+                labels[k - 1].f_label, labels[k - 1].f_length);
+        if(r == -1)
+        {
+            /* we are done, return the previous level */
+            break;
+        }
+    }
+    idx = k;
+
+    /* if there are exceptions we may need to search those now if the
+     * first label is the only one left
+     */
+    if(k == 1)
+    {
+        tld = tld_file_description_unchecked(context->f_file, p);
+        r = label_search_lower(context, tld->f_start_offset, tld->f_end_offset,
+                labels[0].f_label, labels[0].f_length);
+        if(r != -1)
+        {
+            p = r;
+            idx = 0;
+        }
+    }
+
+    tld = tld_file_description_unchecked(context->f_file, p);
+    info->f_status = static_cast<tld_status>(tld->f_status);
+    info->f_tld_index = p;
+    switch(info->f_status)
+    {
+    case TLD_STATUS_VALID:
+        result = TLD_RESULT_SUCCESS;
+        break;
+
+    case TLD_STATUS_EXCEPTION:
+        /* return the actual TLD and not the exception */
+        p = tld->f_exception_apply_to;
+        tld = tld_file_description_unchecked(context->f_file, p);
+        idx = count - tld->f_exception_level;
+        info->f_status = TLD_STATUS_VALID;
+        result = TLD_RESULT_SUCCESS;
+        break;
+
+    default:
+        result = TLD_RESULT_INVALID;
+        break;
+
+    }
+
+    tags_to_info_lite(context, tld, info, fields);
+
+    info->f_tld = labels[idx].f_label;
+    info->f_offset = idx;
+
+    return result;
+}
+
+
+/** \brief Clear the info structure.
+ *
+ * This function initializes the info structure with defaults.
+ * The different TLD functions that make use of this structure
+ * will generally call this function first to represent a
+ * failure case.
+ *
+ * Note that by default the category and status are set to
+ * undefined (TLD_CATEGORY_UNDEFINED and TLD_STATUS_UNDEFINED).
+ * Also the country and tld pointer are set to NULL and thus
+ * they cannot be used as strings.
+ *
+ * \param[out] info  The tld_info structure to clear.
+ */
+void tld_clear_info(struct tld_info *info)
+{
+    info->f_category = TLD_CATEGORY_UNDEFINED;
+    info->f_status = TLD_STATUS_UNDEFINED;
+    memset(info->f_country, 0, sizeof(info->f_country));
+    info->f_tld = (const char *) 0;
+    info->f_offset = -1;
+    info->f_tld_index = -1;
+}
+
+
+/** \brief Clear the lite info structure.
+ *
+ * This function initializes the lite info structure with defaults.
+ * Contrary to tld_clear_info(), there is no country buffer to clear
+ * so this is only a few stores.
+ *
+ * The category and status are set to undefined (TLD_CATEGORY_UNDEFINED
+ * and TLD_STATUS_UNDEFINED), the country and tld pointers are set
+ * to NULL and the offset and index are set to -1.
+ *
+ * \param[out] info  The tld_info_lite structure to clear.
+ */
+void tld_clear_info_lite(struct tld_info_lite *info)
+{
+    info->f_category = TLD_CATEGORY_UNDEFINED;
+    info->f_status = TLD_STATUS_UNDEFINED;
+    info->f_country = (const char *) 0;
+    info->f_country_length = 0;
+    info->f_offset = -1;
+    info->f_tld = (const char *) 0;
+    info->f_tld_index = -1;
+}
+
+
+/** \brief Load a TLDs file in a context.
+ * \internal
+ *
+ * This function releases the TLDs currently found in \p context and
+ * loads \p filename instead. See tld_load_tlds() for details about the
+ * \p filename and \p fallback parameters.
+ *
+ * \param[in,out] context  The context where the TLDs get loaded.
+ * \param[in] filename  The file to load or NULL to load the default.
+ * \param[in] fallback  Whether to fallback to the internal data if the
+ * input file cannot be loaded.
+ *
+ * \return A tld_result representing the success or failure.
+ */
+static enum tld_result context_load(struct tld_context * context, char const * filename, int fallback)
+{
+    enum tld_file_error err;
+
+    free_indexes(context);
+    tld_file_free(&context->f_file);
+
+    if(filename == nullptr)
+    {
+        // first try a user updated version of the file
+        //
+        err = tld_file_map("/var/lib/libtld/tlds.tld", &context->f_file);
+        if(err == TLD_FILE_ERROR_NONE)
+        {
+            build_indexes(context);
+            return TLD_RESULT_SUCCESS;
+        }
+        // else -- ignore any other error
+
+        // second try the default installed version of the file
+        //
+        filename = "/usr/share/libtld/tlds.tld";
+    }
+    // else -- only try with the user defined version
+
+    err = tld_file_map(filename, &context->f_file);
+    if(err == TLD_FILE_ERROR_NONE)
+    {
+        build_indexes(context);
+        return TLD_RESULT_SUCCESS;
+    }
+
+    if(fallback != 0)
+    {
+        // use the descriptions from tld_data.c as fallback; the data is
+        // used in place unless the compiler did not align the array
+        //
+        err = tld_file_load_buffer(tld_static_tlds, tld_get_static_tlds_buffer_size(), &context->f_file);
+        if(err == TLD_FILE_ERROR_INVALID_ALIGNMENT)
+        {
+            std::stringstream in;
+            in.write(reinterpret_cast<char const *>(tld_static_tlds), tld_get_static_tlds_buffer_size());
+            err = tld_file_load_stream(&context->f_file, in);
+        }
+        if(err == TLD_FILE_ERROR_NONE)
+        {
+            build_indexes(context);
+            return TLD_RESULT_SUCCESS;
+        }
+    }
+
+    return err == TLD_FILE_ERROR_CANNOT_OPEN_FILE
+                ? TLD_RESULT_NOT_FOUND
+                : TLD_RESULT_INVALID;
+}
+
+
+/** \brief Record of a thread searching the default context.
+ * \internal
+ *
+ * Each thread that calls one of the functions using the default context
+ * (tld(), tld_check_uri(), etc.) gets one of these records. While the
+ * thread searches the TLDs, f_epoch is set to the epoch that was current
+ * when the search started. The rest of the time it is set to zero.
+ *
+ * The records are never released. When a thread exits, its record is
+ * marked as unused and the next new thread takes it over.
+ */
+struct tld_reader
+{
+    std::atomic<uint64_t>       f_epoch;
+    std::atomic<bool>           f_in_use;
+    struct tld_reader *         f_next;
+};
+
+
+/** \brief A context which was replaced by tld_reload_tlds().
+ * \internal
+ *
+ * The context cannot be released until all the threads which may still
+ * be searching it are done. Those are the threads with a non-zero epoch
+ * smaller than f_epoch.
+ */
+struct tld_retired_context
+{
+    struct tld_context *        f_context;
+    uint64_t                    f_epoch;
+};
+
+
+namespace
+{
+
+
+/** \brief The context used by the functions without a context parameter.
+ * \internal
+ *
+ * At first, this is the g_tld_context. Each call to tld_reload_tlds()
+ * replaces it with a new context.
+ */
+std::atomic<struct tld_context *>   g_tld_current(&g_tld_context);
+
+
+/** \brief The current epoch.
+ * \internal
+ *
+ * The epoch gets incremented each time a context gets retired. It starts
+ * at 1 since an epoch of 0 in a tld_reader means that the thread is not
+ * searching.
+ */
+std::atomic<uint64_t>               g_tld_epoch(1);
+
+
+/** \brief The list of reader records.
+ * \internal
+ *
+ * New records get pushed at the front of the list. Records never get
+ * removed so the list can be read without a lock.
+ */
+std::atomic<struct tld_reader *>    g_tld_readers(nullptr);
+
+
+/** \brief The mutex protecting the list of retired contexts.
+ * \internal
+ *
+ * Only the functions replacing the default context lock this mutex.
+ * The lookups never do.
+ */
+std::mutex                          g_tld_reload_mutex;
+
+
+/** \brief Contexts waiting for their readers to be done.
+ * \internal
+ *
+ * This vector is protected by the g_tld_reload_mutex.
+ */
+std::vector<tld_retired_context>    g_tld_retired;
+
+
+/** \brief Find a reader record for the current thread.
+ * \internal
+ *
+ * This function reuses the record of a thread which exited, if any.
+ * Otherwise it allocates a new record and adds it to the list.
+ *
+ * \return The reader record now owned by the calling thread.
+ */
+struct tld_reader * acquire_reader()
+{
+    struct tld_reader * reader(g_tld_readers.load(std::memory_order_acquire));
+    for(; reader != nullptr; reader = reader->f_next)
+    {
+        bool in_use(false);
+        if(reader->f_in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire))
+        {
+            return reader;
+        }
+    }
+
+    reader = new tld_reader;
+    reader->f_epoch.store(0, std::memory_order_relaxed);
+    reader->f_in_use.store(true, std::memory_order_relaxed);
+    reader->f_next = g_tld_readers.load(std::memory_order_relaxed);
+    while(!g_tld_readers.compare_exchange_weak(
+                          reader->f_next
+                        , reader
+                        , std::memory_order_release
+                        , std::memory_order_relaxed))
+    {
+    }
+
+    return reader;
+}
+
+
+/** \brief Hold the reader record of a thread.
+ * \internal
+ *
+ * The record is acquired the first time the thread searches the default
+ * context and it is marked as unused again when the thread exits.
+ */
+class reader_slot
+{
+public:
+    ~reader_slot()
+    {
+        if(f_reader != nullptr)
+        {
+            f_reader->f_in_use.store(false, std::memory_order_release);
+        }
+    }
+
+    struct tld_reader * get()
+    {
+        if(f_reader == nullptr)
+        {
+            f_reader = acquire_reader();
+        }
+        return f_reader;
+    }
+
+private:
+    struct tld_reader *     f_reader = nullptr;
+};
+
+
+thread_local reader_slot            g_reader_slot;
+
+
+/** \brief Safely use the default context.
+ * \internal
+ *
+ * This object publishes the current epoch in the thread reader record
+ * and then reads the current default context. As long as the object
+ * exists, that context does not get released even if another thread
+ * calls tld_reload_tlds().
+ *
+ * The lookups do not lock anything, they only save the epoch in their
+ * own record.
+ */
+class default_context
+{
+public:
+    default_context()
+        : f_reader(g_reader_slot.get())
+    {
+        // the epoch must be published before we read the context pointer
+        // (both are sequentially consistent)
+        //
+        f_reader->f_epoch.store(g_tld_epoch.load(std::memory_order_acquire));
+        f_context = g_tld_current.load();
+    }
+
+    default_context(default_context const &) = delete;
+    default_context & operator = (default_context const &) = delete;
+
+    ~default_context()
+    {
+        f_reader->f_epoch.store(0, std::memory_order_release);
+    }
+
+    struct tld_context const * get() const
+    {
+        return f_context;
+    }
+
+private:
+    struct tld_reader *         f_reader = nullptr;
+    struct tld_context *        f_context = nullptr;
+};
+
+
+/** \brief Release the TLDs of a context and the context itself.
+ * \internal
+ *
+ * The g_tld_context is static so only its TLDs get released.
+ *
+ * \param[in] context  The context to release.
+ */
+void release_context(struct tld_context * context)
+{
+    free_indexes(context);
+    tld_file_free(&context->f_file);
+    if(context != &g_tld_context)
+    {
+        free(context);
+    }
+}
+
+
+/** \brief Release the retired contexts which are not in use anymore.
+ * \internal
+ *
+ * A retired context can be released once none of the threads is still
+ * searching with an epoch older than the epoch at which the context was
+ * retired. Threads which started their search after that can only see a
+ * newer context.
+ *
+ * The caller must hold the g_tld_reload_mutex.
+ */
+void reclaim_contexts()
+{
+    uint64_t oldest(UINT64_MAX);
+    for(struct tld_reader * reader(g_tld_readers.load(std::memory_order_acquire));
+        reader != nullptr;
+        reader = reader->f_next)
+    {
+        uint64_t const epoch(reader->f_epoch.load());
+        if(epoch != 0
+        && epoch < oldest)
+        {
+            oldest = epoch;
+        }
+    }
+
+    std::size_t kept(0);
+    for(auto const & r : g_tld_retired)
+    {
+        if(r.f_epoch <= oldest)
+        {
+            release_context(r.f_context);
+        }
+        else
+        {
+            g_tld_retired[kept] = r;
+            ++kept;
+        }
+    }
+    g_tld_retired.resize(kept);
+}
+
+
+/** \brief Make g_tld_context the default context again.
+ * \internal
+ *
+ * This function releases all the contexts created by tld_reload_tlds().
+ * It is used by tld_load_tlds() and tld_free_tlds() which are not
+ * thread safe.
+ */
+void reset_default_context()
+{
+    std::lock_guard<std::mutex> lock(g_tld_reload_mutex);
+
+    for(auto const & r : g_tld_retired)
+    {
+        release_context(r.f_context);
+    }
+    g_tld_retired.clear();
+
+    struct tld_context * context(g_tld_current.exchange(&g_tld_context));
+    if(context != &g_tld_context)
+    {
+        release_context(context);
+    }
+}
+
+
+} // no name namespace
+
+
+/** \brief Load a TLDs file as the file to be used by the tld() function.
+ *
+ * This function loads the specified \p filename as the current set of
+ * data to be used by the tld() function.
+ *
+ * You generally do not need to call this function, instead, it will be
+ * automatically called with a null pointer which will load the default
+ * file as expected.
+ *
+ * The \p fallback flag can be set to true (the default) to fallback to
+ * the static version of the data compiled internally. This is used if
+ * the specified or default external file cannot be loaded.
+ *
+ * The file is mapped in memory read-only (see tld_file_map()) so all the
+ * processes using the same file share one copy of the TLDs. If you want
+ * to update the file, write the new version to a temporary file and
+ * rename() it over the old one. Overwriting the file in place would
+ * change the data under the feet of the processes using it.
+ *
+ * \warning
+ * You can call this function at any time to switch between .tld files.
+ * However, any structure loaded with this function prior to a call to
+ * this function must all be considered invalid since some string
+ * pointers in those structures may still point in the old buffer.
+ *
+ * \param[in] filename  The file to load or NULL to load the default.
+ * \param[in] fallback  Whether to fallback to the internal data if the
+ * input file cannot be loaded.
+ *
+ * \return A tld_result representing the success or failure:
+ * TLD_RESULT_SUCCESS for success, TLD_RESULT_INVALID for errors where
+ * the file could not be read, and TLD_RESULT_NOT_FOUND if the file is
+ * not found.
+ */
+enum tld_result tld_load_tlds(char const * filename, int fallback)
+{
+    reset_default_context();
+    return context_load(&g_tld_context, filename, fallback);
+}
+
+
+/** \brief Replace the TLDs while other threads search them.
+ *
+ * This function loads the specified \p filename in a new context and
+ * then makes it the default context used by tld(), tld_check_uri(),
+ * etc. It can be called at any time, even while other threads run
+ * lookups. For example, a thread can call this function once a day
+ * after /var/lib/libtld/tlds.tld was updated.
+ *
+ * The lookups never lock and never wait on this function. They only
+ * save the current epoch in their own record while they search. The new
+ * context gets published with an atomic pointer swap. Then this function
+ * waits until none of the threads is still searching the previous
+ * context and releases it before returning. Since a lookup is short,
+ * the wait is short too. This means the previous TLDs never stay in
+ * memory after this function returns and the lookups never release
+ * anything themselves.
+ *
+ * The \p filename and \p fallback parameters work exactly like with the
+ * tld_load_tlds() function. If the file cannot be loaded, the default
+ * context does not change.
+ *
+ * \warning
+ * The results of a lookup which happened before the reload refer to the
+ * previous TLDs and the previous context is released by the reload.
+ * This means:
+ * \li the tld_info::f_tld_index may not match the same entry in the new
+ *     TLDs so do not pass it to tld_get_tag() after a reload;
+ * \li the tld_tag_definition::f_name and tld_tag_definition::f_value
+ *     pointers returned by tld_get_tag() point to the strings of the
+ *     previous TLDs and become dangling pointers;
+ * \li the tld_info_lite::f_country pointer also points to the strings
+ *     of the previous TLDs and becomes a dangling pointer.
+ *
+ * \par
+ * If you need those strings after a reload, make a copy first.
+ *
+ * \warning
+ * The first load of the default context is not thread safe. If you do
+ * not call tld_load_tlds() or this function yourself, the first lookup
+ * loads the TLDs. That first lookup must happen before you start your
+ * threads. Once the default context is loaded, this function can be
+ * called at any time.
+ *
+ * \warning
+ * The tld_load_tlds() and tld_free_tlds() functions are not thread safe.
+ * Do not call them while other threads run lookups.
+ *
+ * \param[in] filename  The file to load or NULL to load the default.
+ * \param[in] fallback  Whether to fallback to the internal data if the
+ * input file cannot be loaded.
+ *
+ * \return The same results as tld_load_tlds().
+ */
+enum tld_result tld_reload_tlds(char const * filename, int fallback)
+{
+    enum tld_result result;
+    struct tld_context * context;
+    struct tld_context * previous;
+
+    context = static_cast<struct tld_context *>(calloc(1, sizeof(struct tld_context)));
+    if(context == nullptr)
+    {
+        return TLD_RESULT_INVALID; // LCOV_EXCL_LINE
+    }
+
+    // the load happens before we lock anything
+    //
+    result = context_load(context, filename, fallback);
+    if(result != TLD_RESULT_SUCCESS)
+    {
+        release_context(context);
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(g_tld_reload_mutex);
+
+    previous = g_tld_current.exchange(context);
+    g_tld_retired.push_back({ previous, g_tld_epoch.fetch_add(1) + 1 });
+
+    // wait for the threads still searching the previous context, the
+    // lookups never wait on us so this ends as soon as they are done
+    //
+    for(;;)
+    {
+        reclaim_contexts();
+        if(g_tld_retired.empty())
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    return TLD_RESULT_SUCCESS;
+}
+
+
+/** \brief Make sure the default context is loaded.
+ * \internal
+ *
+ * The functions which start threads searching the default context call
+ * this function first. The first load of the default context is not
+ * thread safe so it has to happen before those threads start (see
+ * g_tld_context).
+ *
+ * \return TLD_RESULT_SUCCESS if the default context is loaded, otherwise
+ * the error returned by tld_load_tlds().
+ */
+enum tld_result tld_default_context_ready()
+{
+    default_context const context;
+    return context_ready(context.get());
+}
+
+
+/** \brief Create a new context and load a TLDs file in it.
+ *
+ * This function allocates a new context and loads the specified
+ * \p filename in it. The \p filename and \p fallback parameters work
+ * exactly like with the tld_load_tlds() function.
+ *
+ * The resulting context can be used with all the tld_ctx_...()
+ * functions. Contrary to the default context, it is never changed
+ * behind your back: the TLDs remain the same until you call
+ * tld_context_free(). This means several threads can search a context
+ * while another thread loads a newer version of the TLDs in a separate
+ * context.
+ *
+ * When the function fails, \p *context is set to a null pointer.
+ *
+ * \param[in] filename  The file to load or NULL to load the default.
+ * \param[in] fallback  Whether to fallback to the internal data if the
+ * input file cannot be loaded.
+ * \param[out] context  The new context.
+ *
+ * \return TLD_RESULT_SUCCESS when the context was created, TLD_RESULT_NULL
+ * if \p context is a null pointer, otherwise the same errors as
+ * tld_load_tlds().
+ *
+ * \sa tld_context_free()
+ */
+enum tld_result tld_context_load(char const * filename, int fallback, struct tld_context ** context)
+{
+    enum tld_result result;
+
+    if(context == nullptr)
+    {
+        return TLD_RESULT_NULL;
+    }
+
+    *context = static_cast<struct tld_context *>(calloc(1, sizeof(struct tld_context)));
+    if(*context == nullptr)
+    {
+        return TLD_RESULT_INVALID; // LCOV_EXCL_LINE
+    }
+
+    result = context_load(*context, filename, fallback);
+    if(result != TLD_RESULT_SUCCESS)
+    {
+        tld_context_free(*context);
+        *context = nullptr;
+    }
+
+    return result;
+}
+
+
+/** \brief Release a context.
+ *
+ * This function releases the TLDs and the context created by
+ * tld_context_load(). Once this function returned, the tld_info
+ * structures filled from that context cannot be used anymore since
+ * their pointers may point to the released TLDs.
+ *
+ * The function accepts a null pointer.
+ *
+ * \param[in] context  The context to release.
+ *
+ * \sa tld_context_load()
+ */
+void tld_context_free(struct tld_context * context)
+{
+    if(context != nullptr)
+    {
+        free_indexes(context);
+        tld_file_free(&context->f_file);
+        free(context);
+    }
+}
+
+
+/** \brief Return a pointer to the current list of TLDs.
+ *
+ * This function returns the list of TLDs that were loaded by the
+ * tld_load_tlds() function. If the TLDs were not yet loaded, then
+ * the function returns a nullptr.
+ *
+ * The structure must be considered 100% read-only. It is possible that
+ * the TLDs were loaded from the tld_data.c buffer which means it is
+ * read-only data from the library.
+ *
+ * \warning
+ * Calling the tld_free_tlds() invalidates the pointer returned by this
  * file since it releases all the allocated buffers including the pointer
  * returned by this function.
  *
@@ -808,7 +2361,7 @@ enum tld_result tld_load_tlds(char const * filename, int fallback)
  */
 const struct tld_file * tld_get_tlds()
 {
-    return g_tld_file;
+    return g_tld_current.load()->f_file;
 }
 
 
@@ -827,7 +2380,8 @@ const struct tld_file * tld_get_tlds()
  */
 void tld_free_tlds()
 {
-    tld_file_free(&g_tld_file);
+    reset_default_context();
+    release_context(&g_tld_context);
 }
 
 
@@ -886,6 +2440,22 @@ void tld_free_tlds()
  * above.
  */
 enum tld_result tld_next_tld(struct tld_enumeration_state * state, struct tld_info * info)
+{
+    default_context const context;
+    return tld_ctx_next_tld(context.get(), state, info);
+}
+
+
+/** \brief Same as tld_next_tld() with a specific context.
+ *
+ * This function works exactly like the tld_next_tld() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_next_tld()
+ */
+enum tld_result tld_ctx_next_tld(struct tld_context const * context, struct tld_enumeration_state * state, struct tld_info * info)
 {
     if(state == nullptr
     || info == nullptr)
@@ -895,13 +2465,13 @@ enum tld_result tld_next_tld(struct tld_enumeration_state * state, struct tld_in
 
     tld_clear_info(info);
 
-    enum tld_result loaded = tld_load_tlds_if_not_loaded();
+    enum tld_result loaded = context_ready(context);
     if(loaded != TLD_RESULT_SUCCESS)
     {
         return loaded;
     }
 
-    if(g_tld_file->f_header->f_tld_max_level > std::size(state->f_offset))
+    if(context->f_file->f_header->f_tld_max_level > std::size(state->f_offset))
     {
         return TLD_RESULT_NO_TLD;
     }
@@ -911,12 +2481,12 @@ enum tld_result tld_next_tld(struct tld_enumeration_state * state, struct tld_in
     {
         // set offset for the very first domain name
         //
-        state->f_offset[0] = g_tld_file->f_header->f_tld_start_offset;
+        state->f_offset[0] = context->f_file->f_header->f_tld_start_offset;
     }
 
     // did we reach the end?
     //
-    if(state->f_offset[0] >= g_tld_file->f_header->f_tld_end_offset)
+    if(state->f_offset[0] >= context->f_file->f_header->f_tld_end_offset)
     {
         return TLD_RESULT_NOT_FOUND;
     }
@@ -928,10 +2498,10 @@ enum tld_result tld_next_tld(struct tld_enumeration_state * state, struct tld_in
     *domain = '\0';
     for(int d(0); d <= state->f_depth; ++d)
     {
-        tld = tld_file_description(g_tld_file, state->f_offset[d]);
-        //tld = g_tld_file->f_descriptions + state->f_offset[d];
+        tld = tld_file_description(context->f_file, state->f_offset[d]);
+        //tld = context->f_file->f_descriptions + state->f_offset[d];
         uint32_t length;
-        char const * name = tld_file_string(g_tld_file, tld->f_tld, &length);
+        char const * name = tld_file_string(context->f_file, tld->f_tld, &length);
         if(name == nullptr)
         {
             return TLD_RESULT_BAD_URI;
@@ -976,7 +2546,7 @@ enum tld_result tld_next_tld(struct tld_enumeration_state * state, struct tld_in
     info->f_offset = domain - state->f_domain;
     info->f_tld_index = state->f_offset[state->f_depth];
     info->f_status = static_cast<tld_status>(tld->f_status);
-    tags_to_info(tld, info);
+    tags_to_info(context, tld, info);
 
     // compute the next position now
     //
@@ -990,7 +2560,7 @@ enum tld_result tld_next_tld(struct tld_enumeration_state * state, struct tld_in
         ++state->f_offset[state->f_depth];
         while(state->f_depth > 0)
         {
-            const struct tld_description * parent = g_tld_file->f_descriptions + state->f_offset[state->f_depth - 1];
+            const struct tld_description * parent = context->f_file->f_descriptions + state->f_offset[state->f_depth - 1];
             if(state->f_offset[state->f_depth] < parent->f_end_offset)
             {
                 break;
@@ -1103,275 +2673,848 @@ enum tld_result tld_next_tld(struct tld_enumeration_state * state, struct tld_in
  * an invalid response. (i.e. don't use any of ".example.co.uk.",
  * "example.co.uk.", nor ".example.co.uk")
  *
- * \include example.c
+ * \include example.c
+ *
+ * \param[in] uri  The URI to be checked.
+ * \param[out] info  A pointer to a tld_info structure to save the result.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ */
+enum tld_result tld(char const * uri, struct tld_info * info)
+{
+    return tld_n(uri, uri == nullptr ? 0 : strlen(uri), info);
+}
+
+
+/** \brief Same as tld() with a specific context.
+ *
+ * This function works exactly like the tld() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld()
+ */
+enum tld_result tld_ctx(struct tld_context const * context, char const * uri, struct tld_info * info)
+{
+    return tld_ctx_n(context, uri, uri == nullptr ? 0 : strlen(uri), info);
+}
+
+
+/** \brief Get information about the TLD of a domain name of a known length.
+ *
+ * This function is the same as the tld() function except that the
+ * domain name does not need to be null terminated. Instead, the \p length
+ * parameter defines the number of bytes to use from \p uri. This allows
+ * you to search the TLD of a domain name found in a larger buffer (i.e.
+ * an HTTP header or a DNS packet) without first having to copy the name.
+ *
+ * All the \p length bytes are considered to be part of the domain name.
+ *
+ * \warning
+ * The tld_info::f_tld pointer is set to point within your \p uri buffer.
+ * Since that buffer is not expected to be null terminated, you must use
+ * the \p length and the tld_info::f_offset fields to determine the
+ * length of the TLD instead of using strlen() on the f_tld pointer.
+ *
+ * \param[in] uri  The URI to be checked.
+ * \param[in] length  The number of bytes in \p uri.
+ * \param[out] info  A pointer to a tld_info structure to save the result.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ *
+ * \sa tld()
+ */
+enum tld_result tld_n(char const * uri, size_t length, struct tld_info * info)
+{
+    default_context const context;
+    return tld_ctx_n(context.get(), uri, length, info);
+}
+
+
+/** \brief Same as tld_n() with a specific context.
+ *
+ * This function works exactly like the tld_n() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_n()
+ */
+enum tld_result tld_ctx_n(struct tld_context const * context, char const * uri, size_t length, struct tld_info * info)
+{
+    struct tld_info_lite lite;
+    enum tld_result result;
+
+    /* set defaults in the info structure */
+    tld_clear_info(info);
+
+    result = tld_ctx_lite(context, uri, length, &lite, TLD_INFO_ALL);
+    lite_to_info(&lite, info);
+
+    return result;
+}
+
+
+/** \brief Get information about the TLD of a domain name, lite version.
+ *
+ * This function searches the TLD of \p uri like tld_n() does. The
+ * result is saved in a tld_info_lite structure which does not include
+ * a copy of the country name. This makes it much faster to clear and
+ * set the result when you do many lookups.
+ *
+ * The \p fields parameter is a set of flags defining which of the
+ * optional fields get set:
+ *
+ * \li TLD_INFO_CATEGORY -- set the tld_info_lite::f_category field
+ * \li TLD_INFO_COUNTRY -- set the tld_info_lite::f_country and
+ *     tld_info_lite::f_country_length fields
+ * \li TLD_INFO_ALL -- set all the fields
+ *
+ * The f_status, f_tld, f_offset, and f_tld_index fields are always set
+ * since the lookup determines them anyway. Fields that were not selected
+ * keep the defaults set by tld_clear_info_lite().
+ *
+ * \warning
+ * The tld_info_lite::f_country string is not null terminated. Use the
+ * tld_info_lite::f_country_length field to know its length. The pointer
+ * points inside the TLDs in memory. It remains valid until those TLDs get
+ * released (i.e. tld_free_tlds(), tld_reload_tlds(), or
+ * tld_context_free() is called).
+ *
+ * \param[in] uri  The URI to be checked.
+ * \param[in] length  The number of bytes in \p uri.
+ * \param[out] info  A pointer to a tld_info_lite structure to save the result.
+ * \param[in] fields  The TLD_INFO_... fields to set in \p info.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ *
+ * \sa tld_n()
+ */
+enum tld_result tld_lite(char const * uri, size_t length, struct tld_info_lite * info, int fields)
+{
+    default_context const context;
+    return tld_ctx_lite(context.get(), uri, length, info, fields);
+}
+
+
+/** \brief Same as tld_lite() with a specific context.
+ *
+ * This function works exactly like the tld_lite() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_lite()
+ */
+enum tld_result tld_ctx_lite(struct tld_context const * context, char const * uri, size_t length, struct tld_info_lite * info, int fields)
+{
+    char const * level_buffer[UCHAR_MAX];
+    int level, max_level;
+    enum tld_result result;
+
+    /* set defaults in the info structure */
+    tld_clear_info_lite(info);
+
+    if(uri == nullptr || length == 0)
+    {
+        return TLD_RESULT_NULL;
+    }
+
+    /* before we can go further, we want to load the TLDs file */
+    result = context_ready(context);
+    if(result != TLD_RESULT_SUCCESS)
+    {
+        return result;
+    }
+
+    /* only the last max_level labels can be part of the TLD so we
+     * search for the periods from the end of the URI
+     */
+    max_level = context->f_file->f_header->f_tld_max_level;
+    level = split_levels(uri, uri + length, max_level, level_buffer);
+    if(level < 0)
+    {
+        return TLD_RESULT_BAD_URI;
+    }
+
+    return search_levels(context, uri, uri + length, level_buffer + max_level - level, level, 0, info, fields);
+}
+
+
+/** \brief Get the offset of the public suffix of a domain name.
+ *
+ * This function runs the same search as tld_n(), including the wildcard
+ * and exception rules, and only returns the offset where the suffix
+ * starts. No tld_info structure gets filled and the tags of the TLD are
+ * not looked at. This is useful when all you need is the boundary of the
+ * registrable domain (i.e. to scope cookies).
+ *
+ * The returned offset is the same as the tld_info::f_offset field set
+ * by tld_n() when it returns TLD_RESULT_SUCCESS. It points to the period
+ * before the suffix so the suffix is
+ * <code>host + offset .. host + length</code>.
+ *
+ * \param[in] host  The domain name to be checked.
+ * \param[in] length  The number of bytes in \p host.
+ *
+ * \return The offset of the suffix or -1 if tld_n() would not return
+ * TLD_RESULT_SUCCESS.
+ *
+ * \sa tld_n()
+ */
+int tld_suffix_offset(char const * host, size_t length)
+{
+    default_context const context;
+    return tld_ctx_suffix_offset(context.get(), host, length);
+}
+
+
+/** \brief Same as tld_suffix_offset() with a specific context.
+ *
+ * This function works exactly like the tld_suffix_offset() function
+ * except that it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_suffix_offset()
+ */
+int tld_ctx_suffix_offset(struct tld_context const * context, char const * host, size_t length)
+{
+    struct tld_info_lite info;
+
+    if(tld_ctx_lite(context, host, length, &info, 0) != TLD_RESULT_SUCCESS)
+    {
+        return -1;
+    }
+
+    return info.f_offset;
+}
+
+
+/** \brief Set a span of a tld_uri_parts or tld_domain_parts structure.
+ * \internal
+ *
+ * \param[out] span  The span to set.
+ * \param[in] start  The start of the part.
+ * \param[in] stop  The end of the part (exclusive).
+ * \param[in] origin  The start of the URI or domain name.
+ */
+static void set_span(struct tld_span * span, char const * start, char const * stop, char const * origin)
+{
+    span->f_offset = static_cast<int>(start - origin);
+    span->f_length = static_cast<int>(stop - start);
+}
+
+
+/** \brief Split a domain name in sub-domains, domain, and TLD.
+ *
+ * This function searches the TLD of \p host like tld_n() and then
+ * returns the position of its parts as offsets and lengths within
+ * \p host. Nothing gets allocated and the tags of the TLD are not
+ * looked at. The parts are:
+ *
+ * \li f_sub_domains -- the sub-domains, without the period before the
+ *     domain; this part is absent when there are no sub-domains
+ * \li f_domain -- the registrable domain (a.k.a. eTLD+1), which is the
+ *     label before the TLD followed by the TLD
+ * \li f_tld -- the TLD, starting with its period
+ *
+ * For example, "www.example.co.uk" is split as "www", "example.co.uk",
+ * and ".co.uk".
+ *
+ * The parts are only set when the function returns TLD_RESULT_SUCCESS.
+ * Otherwise their offsets are set to -1 and their lengths to 0. A domain
+ * name which is only a TLD (i.e. "co.uk") has no registrable domain so
+ * it returns TLD_RESULT_BAD_URI, like tld_check_uri() does.
+ *
+ * \param[in] host  The domain name to split.
+ * \param[in] length  The number of bytes in \p host.
+ * \param[out] parts  The structure receiving the parts of \p host.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ *
+ * \sa tld_n()
+ */
+enum tld_result tld_split_domain(char const * host, size_t length, struct tld_domain_parts * parts)
+{
+    default_context const context;
+    return tld_ctx_split_domain(context.get(), host, length, parts);
+}
+
+
+/** \brief Same as tld_split_domain() with a specific context.
+ *
+ * This function works exactly like the tld_split_domain() function
+ * except that it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_split_domain()
+ */
+enum tld_result tld_ctx_split_domain(struct tld_context const * context, char const * host, size_t length, struct tld_domain_parts * parts)
+{
+    struct tld_info_lite info;
+    char const * domain;
+    enum tld_result result;
+
+    parts->f_sub_domains.f_offset = -1;
+    parts->f_sub_domains.f_length = 0;
+    parts->f_domain.f_offset = -1;
+    parts->f_domain.f_length = 0;
+    parts->f_tld.f_offset = -1;
+    parts->f_tld.f_length = 0;
+
+    result = tld_ctx_lite(context, host, length, &info, 0);
+    if(result != TLD_RESULT_SUCCESS)
+    {
+        return result;
+    }
+    if(info.f_offset == 0)
+    {
+        /* if there is only a TLD, then there is no domain */
+        return TLD_RESULT_BAD_URI;
+    }
+
+    /* the domain is the one label found before the TLD */
+    for(domain = host + info.f_offset; domain > host && domain[-1] != '.'; --domain);
+
+    if(domain > host)
+    {
+        set_span(&parts->f_sub_domains, host, domain - 1, host);
+    }
+    set_span(&parts->f_domain, domain, host + length, host);
+    set_span(&parts->f_tld, host + info.f_offset, host + length, host);
+
+    return TLD_RESULT_SUCCESS;
+}
+
+
+/** \brief Check whether a domain name is a public suffix.
+ *
+ * This function returns 1 when the whole of \p host is a TLD, i.e.
+ * a name under which anyone can register a domain such as "com" or
+ * "co.uk". This is the test to apply to the Domain=... attribute
+ * of a cookie, which must not be a public suffix. A period at the
+ * start of \p host is ignored so ".co.uk" is also a public suffix.
+ *
+ * The search is the same as the one of tld_n() and the wildcard and
+ * exception rules apply (i.e. "anything.kawasaki.jp" is a public suffix
+ * but "city.kawasaki.jp" is not). The status of the TLD is not checked
+ * so a deprecated or reserved TLD is still viewed as a public suffix.
+ *
+ * As with tld_n(), the \p host is expected to be in lowercase.
+ *
+ * \param[in] host  The domain name to check.
+ * \param[in] length  The number of bytes in \p host.
+ *
+ * \return 1 if \p host is a public suffix, 0 otherwise.
+ *
+ * \sa tld_same_site()
+ */
+int tld_is_public_suffix(char const * host, size_t length)
+{
+    default_context const context;
+    return tld_ctx_is_public_suffix(context.get(), host, length);
+}
+
+
+/** \brief Same as tld_is_public_suffix() with a specific context.
+ *
+ * This function works exactly like the tld_is_public_suffix() function
+ * except that it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_is_public_suffix()
+ */
+int tld_ctx_is_public_suffix(struct tld_context const * context, char const * host, size_t length)
+{
+    struct tld_info_lite info;
+
+    if(host != nullptr
+    && length > 0
+    && *host == '.')
+    {
+        ++host;
+        --length;
+    }
+
+    switch(tld_ctx_lite(context, host, length, &info, 0))
+    {
+    case TLD_RESULT_SUCCESS:
+    case TLD_RESULT_INVALID:
+        /* an offset of 0 means the TLD covers the whole name */
+        return info.f_offset == 0 ? 1 : 0;
+
+    case TLD_RESULT_NO_TLD:
+        /* a name without periods is a suffix if it is a top level name
+         * (the context is ready since the search got that far)
+         */
+        return label_search(context, context->f_file->f_header->f_tld_start_offset,
+                    context->f_file->f_header->f_tld_end_offset,
+                    host, host + length, 0) != -1 ? 1 : 0;
+
+    default:
+        return 0;
+
+    }
+}
+
+
+/** \brief Check whether two domain names share the same registrable domain.
+ *
+ * This function returns 1 when \p a and \p b have the same registrable
+ * domain (eTLD+1), i.e. "www.example.co.uk" and "shop.example.co.uk"
+ * are the same site. Names which are only a TLD, or which tld_n() does
+ * not accept, are never the same site as anything.
+ *
+ * Nothing gets allocated. The two names are first compared from the end
+ * so names with a different last label are rejected right away without
+ * any TLD search. Only when the common part is long enough for the
+ * registrable domain of \p a is \p b searched.
  *
- * \param[in] uri  The URI to be checked.
- * \param[out] info  A pointer to a tld_info structure to save the result.
+ * The comparison is case sensitive. Use tld_domain_to_lowercase() first
+ * if your names may include uppercase characters.
  *
- * \return One of the TLD_RESULT_... enumeration values.
+ * \param[in] a  The first domain name.
+ * \param[in] a_length  The number of bytes in \p a.
+ * \param[in] b  The second domain name.
+ * \param[in] b_length  The number of bytes in \p b.
+ *
+ * \return 1 if \p a and \p b are the same site, 0 otherwise.
+ *
+ * \sa tld_split_domain()
  */
-enum tld_result tld(char const * uri, struct tld_info * info)
+int tld_same_site(char const * a, size_t a_length, char const * b, size_t b_length)
 {
-    char const * end = uri;
-    struct tld_description const * tld;
-    int level = 0, max_level, start_level, i, r, p, offset;
-    enum tld_result result;
+    default_context const context;
+    return tld_ctx_same_site(context.get(), a, a_length, b, b_length);
+}
 
-    /* set defaults in the info structure */
-    tld_clear_info(info);
 
-    if(uri == nullptr || uri[0] == '\0')
+/** \brief Same as tld_same_site() with a specific context.
+ *
+ * This function works exactly like the tld_same_site() function
+ * except that it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_same_site()
+ */
+int tld_ctx_same_site(struct tld_context const * context, char const * a, size_t a_length, char const * b, size_t b_length)
+{
+    struct tld_domain_parts parts;
+    size_t common;
+    int domain_length;
+
+    if(a == nullptr || b == nullptr)
     {
-        return TLD_RESULT_NULL;
+        return 0;
     }
 
-    /* before we can go further, we want to load the TLDs file */
-    result = tld_load_tlds_if_not_loaded();
-    if(result != TLD_RESULT_SUCCESS)
+    /* length of the common ending of both names, the first differing
+     * label stops this loop
+     */
+    for(common = 0;
+        common < a_length
+            && common < b_length
+            && a[a_length - common - 1] == b[b_length - common - 1];
+        ++common);
+
+    /* when the last label of a is not entirely shared, the names cannot
+     * be the same site and we do not need to search any TLD
+     */
+    if(common < a_length
+    && memchr(a + a_length - common, '.', common) == nullptr)
     {
-        return result;
+        return 0;
     }
 
-    max_level = g_tld_file->f_header->f_tld_max_level;
-    std::vector<const char *> level_ptr(max_level);
-    while(*end != '\0')
+    if(tld_ctx_split_domain(context, a, a_length, &parts) != TLD_RESULT_SUCCESS
+    || static_cast<size_t>(parts.f_domain.f_length) > common)
     {
-        if(*end == '.')
-        {
-            if(level >= max_level)
-            {
-                /* At this point the maximum number of levels in the
-                 * TLDs is 7
-                 */
-                for(i = 1; i < max_level; ++i)
-                {
-                    level_ptr[i - 1] = level_ptr[i];
-                }
-                level_ptr[max_level - 1] = end;
-            }
-            else
-            {
-                level_ptr[level] = end;
-                ++level;
-            }
-            if(level >= 2 && level_ptr[level - 2] + 1 == level_ptr[level - 1])
-            {
-                /* two periods one after another */
-                return TLD_RESULT_BAD_URI;
-            }
-        }
-        ++end;
+        return 0;
     }
-    /* if level is not at least 1 then there are no periods */
-    if(level == 0)
+    domain_length = parts.f_domain.f_length;
+
+    /* b must have the same registrable domain, not only end with it
+     * (i.e. "myexample.com" ends with "example.com")
+     */
+    if(tld_ctx_split_domain(context, b, b_length, &parts) != TLD_RESULT_SUCCESS)
     {
-        /* no TLD */
-        return TLD_RESULT_NO_TLD;
+        return 0;
     }
 
-    start_level = level;
-    --level;
-    r = search(g_tld_file->f_header->f_tld_start_offset,
-                g_tld_file->f_header->f_tld_end_offset,
-                level_ptr[level] + 1, (int) (end - level_ptr[level] - 1));
-    if(r == -1)
+    return parts.f_domain.f_length == domain_length ? 1 : 0;
+}
+
+
+/** \brief Get information about the TLD of a name in DNS wire format.
+ *
+ * DNS packets do not include periods in domain names. Instead each label
+ * is preceded by its length and the name ends with an empty label (the
+ * root). This function searches the TLD of such a name without first
+ * converting it to a string with periods.
+ *
+ * The \p name must be uncompressed (a compression pointer is viewed as
+ * an error) and it may or may not include the final root label. As with
+ * tld_n(), the name must have at least two labels. Since DNS names are
+ * case insensitive, the labels are searched in lowercase.
+ *
+ * On success, the tld_info::f_tld pointer points to the length byte of
+ * the first label of the TLD so the TLD is itself a name in wire format
+ * and tld_info::f_offset is the position of that byte in \p name. The
+ * index of the first label of the TLD is saved in \p suffix_label,
+ * unless that pointer is NULL. It is set to -1 when no TLD is found.
+ *
+ * \param[in] name  The name in DNS wire format.
+ * \param[in] length  The number of bytes in \p name.
+ * \param[out] info  A pointer to a tld_info structure to save the result.
+ * \param[out] suffix_label  The index of the first label of the TLD or NULL.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ *
+ * \sa tld_labels()
+ */
+enum tld_result tld_wire(uint8_t const * name, size_t length, struct tld_info * info, int * suffix_label)
+{
+    default_context const context;
+    return tld_ctx_wire(context.get(), name, length, info, suffix_label);
+}
+
+
+/** \brief Same as tld_wire() with a specific context.
+ *
+ * This function works exactly like the tld_wire() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_wire()
+ */
+enum tld_result tld_ctx_wire(struct tld_context const * context, uint8_t const * name, size_t length, struct tld_info * info, int * suffix_label)
+{
+    /* a name is at most 255 bytes so it has at most 127 labels */
+    struct tld_label labels[128];
+    uint8_t const * s, * end;
+    int count;
+    enum tld_result result;
+
+    if(suffix_label != nullptr)
     {
-        /* unknown */
-        return TLD_RESULT_NOT_FOUND;
+        *suffix_label = -1;
     }
 
-    /* check for the next level if there is one */
-    for(p = r; level > 0; --level, p = r)
+    count = 0;
+    if(name != nullptr)
     {
-        tld = tld_file_description(g_tld_file, r);
-        if(tld == nullptr)
-        {
-            return TLD_RESULT_NOT_FOUND;
-        }
-        if(tld->f_start_offset == USHRT_MAX)
-        {
-            break;
-        }
-        r = search(tld->f_start_offset, tld->f_end_offset,
-                level_ptr[level - 1] + 1,
-                static_cast<int>(level_ptr[level] - level_ptr[level - 1] - 1));
-        if(r == -1)
+        end = name + length;
+        for(s = name; s < end && *s != 0; s += *s + 1)
         {
-            /* we are done, return the previous level */
-            break;
+            if(*s > 63
+            || *s >= end - s
+            || count >= static_cast<int>(sizeof(labels) / sizeof(labels[0])))
+            {
+                /* compression pointer, invalid length, or too many labels */
+                tld_clear_info(info);
+                return TLD_RESULT_BAD_URI;
+            }
+            labels[count].f_label = reinterpret_cast<char const *>(s + 1);
+            labels[count].f_length = *s;
+            ++count;
         }
     }
-    offset = (int) (level_ptr[level] - uri);
 
-    /* if there are exceptions we may need to search those now if level is 0 */
-    if(level == 0)
+    result = tld_ctx_labels(context, count == 0 ? nullptr : labels, count, info);
+    if(info->f_tld != nullptr)
     {
-        tld = tld_file_description(g_tld_file, p);
-        if(tld == nullptr)
-        {
-            return TLD_RESULT_NOT_FOUND;
-        }
-        r = search(tld->f_start_offset,
-                tld->f_end_offset,
-                uri,
-                static_cast<int>(level_ptr[0] - uri));
-        if(r != -1)
+        if(suffix_label != nullptr)
         {
-            p = r;
-            offset = 0;
+            *suffix_label = info->f_offset;
         }
+
+        /* point to the length byte of the first label of the TLD */
+        --info->f_tld;
+        info->f_offset = static_cast<int>(reinterpret_cast<uint8_t const *>(info->f_tld) - name);
     }
 
-    tld = tld_file_description(g_tld_file, p);
-    if(tld == nullptr)
+    return result;
+}
+
+
+/** \brief Get information about the TLD of a name already split in labels.
+ *
+ * This function searches the TLD of a domain name defined as an array
+ * of labels, in the same order as in the domain name (i.e. "www",
+ * "example", "co", "uk"). This is useful when the labels were already
+ * extracted from some other format and avoids rebuilding the name as
+ * a string. The labels do not have to be contiguous in memory. As with
+ * tld_wire(), the labels are searched in lowercase.
+ *
+ * Contrary to tld_n(), the tld_info::f_offset field is set to the index
+ * of the first label of the TLD and tld_info::f_tld points to that label.
+ * An index of 0 means that the whole name is a TLD.
+ *
+ * An empty label is viewed as an error (TLD_RESULT_BAD_URI).
+ *
+ * \param[in] labels  The labels of the domain name.
+ * \param[in] count  The number of labels.
+ * \param[out] info  A pointer to a tld_info structure to save the result.
+ *
+ * \return One of the TLD_RESULT_... enumeration values.
+ *
+ * \sa tld_wire()
+ */
+enum tld_result tld_labels(struct tld_label const * labels, size_t count, struct tld_info * info)
+{
+    default_context const context;
+    return tld_ctx_labels(context.get(), labels, count, info);
+}
+
+
+/** \brief Same as tld_labels() with a specific context.
+ *
+ * This function works exactly like the tld_labels() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_labels()
+ */
+enum tld_result tld_ctx_labels(struct tld_context const * context, struct tld_label const * labels, size_t count, struct tld_info * info)
+{
+    struct tld_info_lite lite;
+    enum tld_result result;
+
+    /* set defaults in the info structure */
+    tld_clear_info(info);
+
+    if(labels == nullptr || count == 0)
     {
-        return TLD_RESULT_NOT_FOUND;
+        return TLD_RESULT_NULL;
     }
-    info->f_status = static_cast<tld_status>(tld->f_status);
-    info->f_tld_index = p;
-    switch(info->f_status)
+    if(count > UCHAR_MAX)
     {
-    case TLD_STATUS_VALID:
-        result = TLD_RESULT_SUCCESS;
-        break;
-
-    case TLD_STATUS_EXCEPTION:
-        /* return the actual TLD and not the exception
-         * i.e. "nacion.ar" is valid and the TLD is just ".ar"
-         * even though top level ".ar" is forbidden by default
-         */
-        p = tld->f_exception_apply_to;
-        tld = tld_file_description(g_tld_file, p);
-        if(tld == nullptr)
+        return TLD_RESULT_BAD_URI;
+    }
+    for(size_t idx(0); idx < count; ++idx)
+    {
+        if(labels[idx].f_label == nullptr
+        || labels[idx].f_length <= 0)
         {
-            return TLD_RESULT_NOT_FOUND;
+            return TLD_RESULT_BAD_URI;
         }
-        level = start_level - tld->f_exception_level;
-        offset = static_cast<int>(level_ptr[level] - uri);
-        info->f_status = TLD_STATUS_VALID;
-        result = TLD_RESULT_SUCCESS;
-        break;
-
-    default:
-        result = TLD_RESULT_INVALID;
-        break;
-
     }
 
-    tags_to_info(tld, info);
+    /* before we can go further, we want to load the TLDs file */
+    result = context_ready(context);
+    if(result != TLD_RESULT_SUCCESS)
+    {
+        return result;
+    }
 
-    info->f_tld = level_ptr[level];
-    info->f_offset = offset;
+    tld_clear_info_lite(&lite);
+    result = search_labels(context, labels, static_cast<int>(count), &lite, TLD_INFO_ALL);
+    lite_to_info(&lite, info);
 
     return result;
 }
 
 
-/** \brief Check that a URI is valid.
+/** \brief A compiled list of protocols.
  *
- * This function very quickly parses a URI to determine whether it
- * is valid.
+ * This structure is created by tld_protocols_compile(). It holds the
+ * lowercase protocol names in a hash table so checking a protocol
+ * does not depend on the number of protocols in the list.
  *
- * Note that it does not (currently) support local naming conventions
- * which means that a host such as "localhost" will fail the test.
+ * The structure, its slots, and its names are allocated in one block.
+ */
+struct tld_protocols
+{
+    int                         f_any;      // the list includes "*"
+    uint32_t                    f_mask;
+    uint32_t *                  f_slots;    // offset + 1 of names in f_names
+    char *                      f_names;
+};
+
+
+/** \brief Compute the hash of a protocol name.
+ * \internal
  *
- * The \p protocols variable can be set to a list of protocol names
- * that are considered valid. For example, for HTTP protocol one
- * could use "http,https". To accept any protocol use an asterisk
- * as in: "*". The protocol must be only characters, digits, or
- * underscores ([0-9A-Za-z_]+) and it must be at least one character.
+ * The protocol names are case insensitive so the hash is computed
+ * on the lowercase version of \p name.
  *
- * The flags can be set to the following values, or them to set multiple
- * flags at the same time:
+ * \param[in] name  The protocol name.
+ * \param[in] n  The length of \p name.
  *
- * \li VALID_URI_ASCII_ONLY -- refuse characters that are not in the
- * first 127 range (we expect the URI to be UTF-8 encoded and any
- * byte with bit 7 set is considered invalid if this flag is set,
- * including encoded bytes such as %A0)
- * \li VALID_URI_NO_SPACES -- refuse spaces whether they are encoded
- * with + or %20 or verbatim.
+ * \return The FNV-1a hash of the lowercase name.
+ */
+static uint32_t hash_protocol(char const * name, int n)
+{
+    uint32_t h(2166136261U);
+    for(int idx(0); idx < n; ++idx)
+    {
+        h = (h ^ static_cast<unsigned char>(tolower(name[idx]))) * 16777619U;
+    }
+    return h;
+}
+
+
+/** \brief Search a protocol in a compiled list of protocols.
+ * \internal
  *
- * The return value is generally TLD_RESULT_BAD_URI when an invalid
- * character is found in the URI string. The TLD_RESULT_NULL is
- * returned if the URI is a NULL pointer or an empty string.
- * Other results may be returned by the tld() function. If a result
- * other than TLD_RESULT_SUCCESS is returned then the info structure
- * may or may not be updated.
+ * \param[in] protocols  The compiled protocols.
+ * \param[in] name  The protocol to search.
+ * \param[in] n  The length of \p name.
+ *
+ * \return 1 if the protocol is accepted, 0 otherwise.
+ */
+static int match_protocol(struct tld_protocols const * protocols, char const * name, int n)
+{
+    uint32_t idx, slot;
+    char const * s;
+    int i;
+
+    if(protocols->f_any != 0)
+    {
+        return 1;
+    }
+
+    for(idx = hash_protocol(name, n) & protocols->f_mask;
+        (slot = protocols->f_slots[idx]) != 0;
+        idx = (idx + 1) & protocols->f_mask)
+    {
+        s = protocols->f_names + slot - 1;
+        for(i = 0; i < n && s[i] == tolower(name[i]); ++i);
+        if(i == n && s[i] == '\0')
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/** \brief Check a URI against a list of protocols.
+ * \internal
  *
+ * This function is the implementation of the tld_ctx_check_uri_n() and
+ * tld_ctx_check_uri_ex() functions. The protocols are either defined in
+ * the \p protocols string or in the \p compiled protocols. One of the
+ * two pointers must be NULL.
+ *
+ * \param[in] context  The context with the TLDs.
  * \param[in] uri  The URI which validity is being checked.
+ * \param[in] length  The number of bytes in \p uri.
  * \param[out] info  The resulting information about the URI domain and TLD.
  * \param[in] protocols  List of comma separated protocols accepted.
+ * \param[in] compiled  The protocols returned by tld_protocols_compile().
  * \param[in] flags  A set of flags to tell the function what is valid/invalid.
+ * \param[out] parts  The parts of the URI or NULL.
  *
  * \return The result of the operation, TLD_RESULT_SUCCESS if the URI is
  * valid.
- *
- * \sa tld()
  */
-enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const char * protocols, int flags)
+static enum tld_result check_uri(struct tld_context const * context, const char * uri, size_t length, struct tld_info * info, const char * protocols, struct tld_protocols const * compiled, int flags, struct tld_uri_parts * parts)
 {
-    const char      *p, *q, *username, *password, *host, *port, *n, *a, *query_string;
-    char            domain[256];
-    int             protocol_length, length, valid, c, i, j, anchor;
+    const char      *p, *q, *username, *password, *host, *port, *n, *a, *query_string, *end, *period_end;
+    const char      *path_end, *query, *fragment, *domain, *sub_domains_end;
+    const char      *periods[UCHAR_MAX + 1], *level_buffer[UCHAR_MAX];
+    size_t          period_count;
+    int             protocol_length, valid, c, i, anchor, decode, double_period, level, max_level, stop;
+    struct tld_info_lite lite;
     enum tld_result result;
 
     /* set defaults in the info structure */
     tld_clear_info(info);
+    if(parts != nullptr)
+    {
+        tld_clear_uri_parts(parts);
+    }
 
-    if(uri == nullptr || uri[0] == '\0')
+    if(uri == nullptr || length == 0)
     {
         return TLD_RESULT_NULL;
     }
+    end = uri + length;
 
     /* check the protocol: [0-9A-Za-z_]+ */
-    for(p = uri; *uri != '\0' && *uri != ':'; ++uri)
+    for(p = uri; uri < end && *uri != ':'; ++uri)
     {
-        if((*uri < 'a' || *uri > 'z')
-        && (*uri < 'A' || *uri > 'Z')
-        && (*uri < '0' || *uri > '9')
-        && *uri != '_')
+        if((g_uri_class[(unsigned char) *uri] & URI_CLASS_PROTOCOL) == 0)
         {
             return TLD_RESULT_BAD_URI;
         }
     }
     valid = 0;
     protocol_length = (int) (uri - p);
-    c = tolower(*p);
-    for(q = protocols; *q != '\0';)
+    if(compiled != nullptr)
     {
-        if(q[0] == '*' && (q[1] == '\0' || q[1] == ','))
-        {
-            valid = 1;
-            break;
-        }
-        if(tolower(*q) == c)
+        valid = match_protocol(compiled, p, protocol_length);
+    }
+    else
+    {
+        c = tolower(*p);
+        for(q = protocols; *q != '\0';)
         {
-            if(strncasecmp(p, q, protocol_length) == 0
-            && (q[protocol_length] == '\0' || q[protocol_length] == ','))
+            if(q[0] == '*' && (q[1] == '\0' || q[1] == ','))
             {
                 valid = 1;
                 break;
             }
+            if(tolower(*q) == c)
+            {
+                if(strncasecmp(p, q, protocol_length) == 0
+                && (q[protocol_length] == '\0' || q[protocol_length] == ','))
+                {
+                    valid = 1;
+                    break;
+                }
+            }
+            /* move to the next protocol */
+            for(; *q != '\0' && *q != ','; ++q);
+            for(; *q == ','; ++q);
         }
-        /* move to the next protocol */
-        for(; *q != '\0' && *q != ','; ++q);
-        for(; *q == ','; ++q);
     }
     if(valid == 0)
     {
         return TLD_RESULT_BAD_URI;
     }
-    if(uri[1] != '/' || uri[2] != '/')
+    if(end - uri < 3 || uri[1] != '/' || uri[2] != '/')
     {
         return TLD_RESULT_BAD_URI;
     }
     uri += 3; /* skip the '://' */
 
-    /* extract the complete domain name with sub-domains, etc. */
+    /* extract the complete domain name with sub-domains, etc.
+     *
+     * the periods of the host are saved as we go so the TLD can be
+     * searched without scanning or copying the host again; only the
+     * last periods are used so the periods[] buffer is a ring
+     */
     username = nullptr;
+    password = nullptr;
     host = uri;
-    for(; *uri != '/' && *uri != '\0'; ++uri)
+    port = nullptr;
+    period_count = 0;
+    period_end = nullptr;
+    decode = 0;
+    double_period = 0;
+    stop = URI_CLASS_CONTROL | URI_CLASS_SPACE | URI_CLASS_PERCENT | URI_CLASS_HOST;
+    if((flags & VALID_URI_ASCII_ONLY) != 0)
+    {
+        stop |= URI_CLASS_HIGH;
+    }
+    for(;; ++uri)
     {
+        /* quickly skip the characters without any special meaning */
+        uri = skip_uri_characters(uri, end, stop);
+        if(uri >= end || *uri == '/')
+        {
+            break;
+        }
         if((unsigned char) *uri < ' ')
         {
             /* forbid control characters in domain name */
@@ -1386,6 +3529,33 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
             }
             username = host;
             host = uri + 1;
+
+            /* what we found so far was the username and password */
+            port = nullptr;
+            period_count = 0;
+            period_end = nullptr;
+            decode = 0;
+            double_period = 0;
+        }
+        else if(*uri == ':')
+        {
+            if(port == nullptr)
+            {
+                port = uri;
+            }
+        }
+        else if(*uri == '.')
+        {
+            if(port == nullptr)
+            {
+                if(uri == period_end)
+                {
+                    /* two periods one after another */
+                    double_period = 1;
+                }
+                periods[period_count++ & UCHAR_MAX] = uri;
+                period_end = uri + 1;
+            }
         }
         else if((*uri & 0x80) != 0)
         {
@@ -1406,12 +3576,10 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
              * note that the first digit must be at least 2 because
              * we do not allow control characters
              */
-            if(((uri[1] < '2' || uri[1] > '9')
-             && (uri[1] < 'a' || uri[1] > 'f')
-             && (uri[1] < 'A' || uri[1] > 'F'))
-            || ((uri[2] < '0' || uri[2] > '9')
-             && (uri[2] < 'a' || uri[2] > 'f')
-             && (uri[2] < 'A' || uri[2] > 'F')))
+            if(end - uri < 3
+            || uri[1] < '2'
+            || (g_uri_class[(unsigned char) uri[1]] & URI_CLASS_HEX) == 0
+            || (g_uri_class[(unsigned char) uri[2]] & URI_CLASS_HEX) == 0)
             {
                 return TLD_RESULT_BAD_URI;
             }
@@ -1425,6 +3593,20 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
                 /* only ASCII allowed by caller */
                 return TLD_RESULT_BAD_URI;
             }
+            if(port == nullptr)
+            {
+                decode = 1;
+                if(uri[1] == '2' && (uri[2] == 'e' || uri[2] == 'E'))
+                {
+                    /* an encoded period */
+                    if(uri == period_end)
+                    {
+                        double_period = 1;
+                    }
+                    periods[period_count++ & UCHAR_MAX] = uri;
+                    period_end = uri + 3;
+                }
+            }
             /* skip the two digits right away */
             uri += 2;
         }
@@ -1447,15 +3629,18 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
             return TLD_RESULT_BAD_URI;
         }
     }
-    for(port = host; *port != ':' && port < uri; ++port);
-    if(*port == ':')
+    if(port == nullptr)
+    {
+        port = uri;
+    }
+    else
     {
         // we have a port, at this time it must be digits [0-9]+
         // (this is incorrect, a port could be a name such as "https";
         // also my current numeric test is invalid, it should make sure
         // it's in range: 0 to 65,535)
         //
-        for(n = port + 1; *n >= '0' && *n <= '9'; ++n);
+        for(n = port + 1; n < uri && *n >= '0' && *n <= '9'; ++n);
         if(n != uri || n == port + 1)
         {
             /* port is empty or includes invalid characters */
@@ -1467,8 +3652,26 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
     //
     query_string = nullptr;
     anchor = 0;
-    for(a = uri; *a != '\0'; ++a)
+    path_end = nullptr;
+    query = nullptr;
+    fragment = nullptr;
+    stop = URI_CLASS_CONTROL | URI_CLASS_QUERY | URI_CLASS_PERCENT;
+    if((flags & VALID_URI_NO_SPACES) != 0)
+    {
+        stop |= URI_CLASS_SPACE;
+    }
+    if((flags & VALID_URI_ASCII_ONLY) != 0)
+    {
+        stop |= URI_CLASS_HIGH;
+    }
+    for(a = uri;; ++a)
     {
+        /* quickly skip the characters without any special meaning */
+        a = skip_uri_characters(a, end, stop);
+        if(a >= end)
+        {
+            break;
+        }
         if((unsigned char) *a < ' ')
         {
             // no control characters allowed
@@ -1496,6 +3699,11 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
                 }
 
                 query_string = a + 1;
+                query = a + 1;
+                if(path_end == nullptr)
+                {
+                    path_end = a;
+                }
             }
         }
         else if(*a == '&' && anchor == 0)
@@ -1522,6 +3730,14 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
         }
         else if(*a == '#')
         {
+            if(anchor == 0)
+            {
+                fragment = a + 1;
+                if(path_end == nullptr)
+                {
+                    path_end = a;
+                }
+            }
             query_string = nullptr;
             anchor = 1;
         }
@@ -1531,12 +3747,10 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
              * note that the first digit must be at least 2 because
              * we do not allow control characters
              */
-            if(((a[1] < '2' || a[1] > '9')
-             && (a[1] < 'a' || a[1] > 'f')
-             && (a[1] < 'A' || a[1] > 'F'))
-            || ((a[2] < '0' || a[2] > '9')
-             && (a[2] < 'a' || a[2] > 'f')
-             && (a[2] < 'A' || a[2] > 'F')))
+            if(end - a < 3
+            || a[1] < '2'
+            || (g_uri_class[(unsigned char) a[1]] & URI_CLASS_HEX) == 0
+            || (g_uri_class[(unsigned char) a[2]] & URI_CLASS_HEX) == 0)
             {
                 return TLD_RESULT_BAD_URI;
             }
@@ -1566,50 +3780,41 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
     /* check the domain */
 
 /** \todo
- * The following is WRONG:
- * \li the domain \%XX are not being checked properly, as it stands the
- *     characters following % can be anything!
- * \li the tld() function must be called with the characters still
- *     encoded; if you look at the data, you will see that I kept
- *     the data encoded (i.e. with the \%XX characters)
- * \li what could be checked (which I guess could be for the entire
- *     domain name) is whether the entire string represents valid
- *     UTF-8; I don't think I'm currently doing so here. (I have
- *     such functions in the tld_domain_to_lowercase() now)
- */
-
-    length = (int) (port - host);
-    if(length >= (int) (sizeof(domain) / sizeof(domain[0])))
-    {
-        /* sub-domains + domain + TLD is more than 255 characters?!
-         * note that the host main include many %XX characters but
-         * we ignore the fact here at this time; we could move this
-         * test in the for() loop below though.
-         */
-        return TLD_RESULT_BAD_URI;
-    }
-    if(length == 0)
+ * What could still be checked (which I guess could be for the entire
+ * domain name) is whether the decoded host represents valid UTF-8;
+ * I don't think I'm currently doing so here. (I have such functions
+ * in the tld_domain_to_lowercase() now)
+ */
+
+    if(port == host)
     {
         // although we could return TLD_RESULT_NULL it would not be
         // valid here because "http:///blah.com" is invalid, not nullptr
         //
         return TLD_RESULT_BAD_URI;
     }
-    for(i = 0, j = 0; i < length; ++i, ++j)
+
+    result = context_ready(context);
+    if(result != TLD_RESULT_SUCCESS)
     {
-        if(host[i] == '%')
-        {
-            domain[j] = (char) (h2d(host[i + 1]) * 16 + h2d(host[i + 2]));
-            i += 2; // skip the 2 digits
-        }
-        else
-        {
-            domain[j] = host[i];
-        }
-        /* TODO: check that characters are acceptable in a domain name (done above, right?) */
+        return result;
+    }
+    if(double_period != 0)
+    {
+        return TLD_RESULT_BAD_URI;
+    }
+
+    /* only the last max_level periods are required */
+    max_level = context->f_file->f_header->f_tld_max_level;
+    level = period_count < static_cast<size_t>(max_level) ? static_cast<int>(period_count) : max_level;
+    for(i = 0; i < level; ++i)
+    {
+        level_buffer[i] = periods[(period_count - level + i) & UCHAR_MAX];
     }
-    domain[j] = '\0';
-    result = tld(domain, info);
+
+    tld_clear_info_lite(&lite);
+    result = search_levels(context, host, port, level_buffer, level, decode, &lite, TLD_INFO_ALL);
+    lite_to_info(&lite, info);
     if(info->f_tld != nullptr)
     {
         if(info->f_offset == 0)
@@ -1619,20 +3824,448 @@ enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const ch
             return TLD_RESULT_BAD_URI;
         }
 
-        // define the TLD inside the source string which "unfortunately"
+        // the TLD is inside the source string which "unfortunately"
         // is not null terminated by '\0'; also fix the offset since in
         // the complete URI the TLD is a bit further away
         //
         // note that `p` is the position at the start of the protocol
         // (at the start of 'uri' at the start)
         //
-        info->f_tld = host + info->f_offset;
         info->f_offset = (int) (info->f_tld - p);
     }
+
+    if(parts != nullptr && result == TLD_RESULT_SUCCESS)
+    {
+        /* the registrable domain starts with the label before the TLD */
+        for(i = 0; i < level && level_buffer[i] != info->f_tld; ++i);
+        if(i > 0)
+        {
+            sub_domains_end = level_buffer[i - 1];
+        }
+        else if(period_count > static_cast<size_t>(level))
+        {
+            sub_domains_end = periods[(period_count - level - 1) & UCHAR_MAX];
+        }
+        else
+        {
+            sub_domains_end = nullptr;
+        }
+        domain = sub_domains_end == nullptr ? host : label_start(sub_domains_end);
+
+        set_span(&parts->f_protocol, p, p + protocol_length, p);
+        if(username != nullptr)
+        {
+            set_span(&parts->f_username, username, password, p);
+            if(*password == ':')
+            {
+                set_span(&parts->f_password, password + 1, host - 1, p);
+            }
+        }
+        set_span(&parts->f_host, host, port, p);
+        if(sub_domains_end != nullptr)
+        {
+            set_span(&parts->f_sub_domains, host, sub_domains_end, p);
+        }
+        set_span(&parts->f_domain, domain, port, p);
+        set_span(&parts->f_tld, info->f_tld, port, p);
+        if(port < uri)
+        {
+            set_span(&parts->f_port, port + 1, uri, p);
+        }
+        if(uri < end)
+        {
+            set_span(&parts->f_path, uri, path_end == nullptr ? end : path_end, p);
+        }
+        if(query != nullptr)
+        {
+            set_span(&parts->f_query_string, query, fragment == nullptr ? end : fragment - 1, p);
+        }
+        if(fragment != nullptr)
+        {
+            set_span(&parts->f_anchor, fragment, end, p);
+        }
+    }
+
     return result;
 }
 
 
+/** \brief Check that a URI is valid.
+ *
+ * This function very quickly parses a URI to determine whether it
+ * is valid.
+ *
+ * Note that it does not (currently) support local naming conventions
+ * which means that a host such as "localhost" will fail the test.
+ *
+ * The host is validated and its periods are found in a single pass.
+ * The TLD is then searched directly in \p uri, so the host does not
+ * get copied and its length is not limited. The tld_info::f_tld
+ * pointer points inside \p uri. Note that a period encoded as "%2E"
+ * is viewed as a period.
+ *
+ * The \p protocols variable can be set to a list of protocol names
+ * that are considered valid. For example, for HTTP protocol one
+ * could use "http,https". To accept any protocol use an asterisk
+ * as in: "*". The protocol must be only characters, digits, or
+ * underscores ([0-9A-Za-z_]+) and it must be at least one character.
+ *
+ * The flags can be set to the following values, or them to set multiple
+ * flags at the same time:
+ *
+ * \li VALID_URI_ASCII_ONLY -- refuse characters that are not in the
+ * first 127 range (we expect the URI to be UTF-8 encoded and any
+ * byte with bit 7 set is considered invalid if this flag is set,
+ * including encoded bytes such as %A0)
+ * \li VALID_URI_NO_SPACES -- refuse spaces whether they are encoded
+ * with + or %20 or verbatim.
+ *
+ * The return value is generally TLD_RESULT_BAD_URI when an invalid
+ * character is found in the URI string. The TLD_RESULT_NULL is
+ * returned if the URI is a NULL pointer or an empty string.
+ * Other results may be returned by the tld() function. If a result
+ * other than TLD_RESULT_SUCCESS is returned then the info structure
+ * may or may not be updated.
+ *
+ * \param[in] uri  The URI which validity is being checked.
+ * \param[out] info  The resulting information about the URI domain and TLD.
+ * \param[in] protocols  List of comma separated protocols accepted.
+ * \param[in] flags  A set of flags to tell the function what is valid/invalid.
+ *
+ * \return The result of the operation, TLD_RESULT_SUCCESS if the URI is
+ * valid.
+ *
+ * \sa tld()
+ * \sa tld_check_uri_n()
+ */
+enum tld_result tld_check_uri(const char * uri, struct tld_info * info, const char * protocols, int flags)
+{
+    return tld_check_uri_n(uri, uri == nullptr ? 0 : strlen(uri), info, protocols, flags);
+}
+
+
+/** \brief Same as tld_check_uri() with a specific context.
+ *
+ * This function works exactly like the tld_check_uri() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_check_uri()
+ */
+enum tld_result tld_ctx_check_uri(struct tld_context const * context, const char * uri, struct tld_info * info, const char * protocols, int flags)
+{
+    return tld_ctx_check_uri_n(context, uri, uri == nullptr ? 0 : strlen(uri), info, protocols, flags);
+}
+
+
+/** \brief Check that a URI of a known length is valid.
+ *
+ * This function is the same as the tld_check_uri() function except that
+ * the URI does not need to be null terminated. The \p length parameter
+ * defines the number of bytes to check in \p uri.
+ *
+ * Since all the \p length bytes are part of the URI, a '\\0' found in
+ * the buffer is viewed as a control character and the function returns
+ * TLD_RESULT_BAD_URI.
+ *
+ * \warning
+ * The tld_info::f_tld pointer is set to point within your \p uri buffer.
+ * It is not null terminated.
+ *
+ * \param[in] uri  The URI which validity is being checked.
+ * \param[in] length  The number of bytes in \p uri.
+ * \param[out] info  The resulting information about the URI domain and TLD.
+ * \param[in] protocols  List of comma separated protocols accepted.
+ * \param[in] flags  A set of flags to tell the function what is valid/invalid.
+ *
+ * \return The result of the operation, TLD_RESULT_SUCCESS if the URI is
+ * valid.
+ *
+ * \sa tld_check_uri()
+ */
+enum tld_result tld_check_uri_n(const char * uri, size_t length, struct tld_info * info, const char * protocols, int flags)
+{
+    default_context const context;
+    return tld_ctx_check_uri_n(context.get(), uri, length, info, protocols, flags);
+}
+
+
+/** \brief Same as tld_check_uri_n() with a specific context.
+ *
+ * This function works exactly like the tld_check_uri_n() function except that
+ * it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_check_uri_n()
+ */
+enum tld_result tld_ctx_check_uri_n(struct tld_context const * context, const char * uri, size_t length, struct tld_info * info, const char * protocols, int flags)
+{
+    return check_uri(context, uri, length, info, protocols, nullptr, flags, nullptr);
+}
+
+
+/** \brief Check that a URI is valid using a compiled list of protocols.
+ *
+ * This function is the same as the tld_check_uri_n() function except that
+ * the list of accepted protocols was first compiled with the
+ * tld_protocols_compile() function. This is much faster when you check
+ * many URIs against the same list, especially if the list is long,
+ * since the list does not get parsed on each call and the protocol is
+ * found in a hash table.
+ *
+ * If \p protocols is NULL, no protocol is accepted and the function
+ * returns TLD_RESULT_BAD_URI.
+ *
+ * \param[in] uri  The URI which validity is being checked.
+ * \param[in] length  The number of bytes in \p uri.
+ * \param[out] info  The resulting information about the URI domain and TLD.
+ * \param[in] protocols  The protocols returned by tld_protocols_compile().
+ * \param[in] flags  A set of flags to tell the function what is valid/invalid.
+ *
+ * \return The result of the operation, TLD_RESULT_SUCCESS if the URI is
+ * valid.
+ *
+ * \sa tld_check_uri_n()
+ * \sa tld_protocols_compile()
+ */
+enum tld_result tld_check_uri_ex(const char * uri, size_t length, struct tld_info * info, struct tld_protocols const * protocols, int flags)
+{
+    default_context const context;
+    return tld_ctx_check_uri_ex(context.get(), uri, length, info, protocols, flags);
+}
+
+
+/** \brief Same as tld_check_uri_ex() with a specific context.
+ *
+ * This function works exactly like the tld_check_uri_ex() function except
+ * that it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_check_uri_ex()
+ */
+enum tld_result tld_ctx_check_uri_ex(struct tld_context const * context, const char * uri, size_t length, struct tld_info * info, struct tld_protocols const * protocols, int flags)
+{
+    if(protocols == nullptr)
+    {
+        tld_clear_info(info);
+        return uri == nullptr || length == 0 ? TLD_RESULT_NULL : TLD_RESULT_BAD_URI;
+    }
+    return check_uri(context, uri, length, info, nullptr, protocols, flags, nullptr);
+}
+
+
+/** \brief Clear the URI parts structure.
+ *
+ * This function marks all the parts of a tld_uri_parts structure as
+ * not present: the offsets are set to -1 and the lengths to 0.
+ *
+ * \param[out] parts  The tld_uri_parts structure to clear.
+ */
+void tld_clear_uri_parts(struct tld_uri_parts * parts)
+{
+    struct tld_span * spans[] =
+    {
+        &parts->f_protocol,
+        &parts->f_username,
+        &parts->f_password,
+        &parts->f_host,
+        &parts->f_sub_domains,
+        &parts->f_domain,
+        &parts->f_tld,
+        &parts->f_port,
+        &parts->f_path,
+        &parts->f_query_string,
+        &parts->f_anchor,
+    };
+
+    for(auto span : spans)
+    {
+        span->f_offset = -1;
+        span->f_length = 0;
+    }
+}
+
+
+/** \brief Check a URI and return the position of each one of its parts.
+ *
+ * This function is the same as the tld_check_uri_ex() function except
+ * that it also saves the position of the different parts of the URI in
+ * \p parts. The positions are found while the URI gets validated so it
+ * is not necessary to parse the URI a second time.
+ *
+ * Each part is defined by an offset from the start of \p uri and a
+ * length. The offset is -1 when the part is not present. The delimiters
+ * are not included: the protocol does not include the "://", the query
+ * string does not include the '?', the anchor does not include the '#',
+ * etc. The path includes its first '/'. The tld part starts with the
+ * period (just like tld_info::f_tld), the domain is the registrable
+ * domain (the label before the TLD and the TLD), and the sub-domains
+ * are the labels before the domain without the last period.
+ *
+ * For example, with "https://me:pw@www.m2osw.co.uk:8080/a/b?x=1#top":
+ *
+ * \li protocol -- "https"
+ * \li username -- "me"
+ * \li password -- "pw"
+ * \li host -- "www.m2osw.co.uk"
+ * \li sub-domains -- "www"
+ * \li domain -- "m2osw.co.uk"
+ * \li tld -- ".co.uk"
+ * \li port -- "8080"
+ * \li path -- "/a/b"
+ * \li query string -- "x=1"
+ * \li anchor -- "top"
+ *
+ * The parts are only defined when the function returns
+ * TLD_RESULT_SUCCESS. Otherwise all the parts are marked as not present.
+ *
+ * \param[in] uri  The URI which validity is being checked.
+ * \param[in] length  The number of bytes in \p uri.
+ * \param[out] info  The resulting information about the URI domain and TLD.
+ * \param[in] protocols  The protocols returned by tld_protocols_compile().
+ * \param[in] flags  A set of flags to tell the function what is valid/invalid.
+ * \param[out] parts  The structure receiving the parts of the URI.
+ *
+ * \return The result of the operation, TLD_RESULT_SUCCESS if the URI is
+ * valid.
+ *
+ * \sa tld_check_uri_ex()
+ */
+enum tld_result tld_check_uri_parts(const char * uri, size_t length, struct tld_info * info, struct tld_protocols const * protocols, int flags, struct tld_uri_parts * parts)
+{
+    default_context const context;
+    return tld_ctx_check_uri_parts(context.get(), uri, length, info, protocols, flags, parts);
+}
+
+
+/** \brief Same as tld_check_uri_parts() with a specific context.
+ *
+ * This function works exactly like the tld_check_uri_parts() function
+ * except that it uses the TLDs of \p context instead of the default TLDs.
+ *
+ * \param[in] context  The context created with tld_context_load().
+ *
+ * \sa tld_check_uri_parts()
+ */
+enum tld_result tld_ctx_check_uri_parts(struct tld_context const * context, const char * uri, size_t length, struct tld_info * info, struct tld_protocols const * protocols, int flags, struct tld_uri_parts * parts)
+{
+    if(protocols == nullptr)
+    {
+        tld_clear_info(info);
+        tld_clear_uri_parts(parts);
+        return uri == nullptr || length == 0 ? TLD_RESULT_NULL : TLD_RESULT_BAD_URI;
+    }
+    return check_uri(context, uri, length, info, nullptr, protocols, flags, parts);
+}
+
+
+/** \brief Compile a list of protocols.
+ *
+ * The tld_check_uri() function parses its list of protocols each time it
+ * gets called. When many URIs are checked against the same list, it is
+ * much faster to compile the list once with this function and then call
+ * tld_check_uri_ex() instead.
+ *
+ * The \p list has the same format as the protocols parameter of
+ * the tld_check_uri() function: a list of comma separated protocol names.
+ * The names are case insensitive. An asterisk ("*") accepts any protocol.
+ *
+ * The returned object is never modified so it can be used by many threads
+ * at the same time. Release it with tld_protocols_free() once done.
+ *
+ * \param[in] list  The list of comma separated protocols.
+ *
+ * \return The compiled protocols or NULL if \p list is NULL or the memory
+ * could not be allocated.
+ *
+ * \sa tld_check_uri_ex()
+ * \sa tld_protocols_free()
+ */
+struct tld_protocols * tld_protocols_compile(const char * list)
+{
+    struct tld_protocols * protocols;
+    char const * q, * e;
+    size_t count, length, size;
+    uint32_t idx;
+    char * names;
+    int n;
+
+    if(list == nullptr)
+    {
+        return nullptr;
+    }
+
+    /* the number of names defines the size of the hash table */
+    count = 1;
+    length = strlen(list);
+    for(q = list; *q != '\0'; ++q)
+    {
+        if(*q == ',')
+        {
+            ++count;
+        }
+    }
+    for(size = 4; size < count * 2; size *= 2);
+
+    protocols = static_cast<struct tld_protocols *>(calloc(1, sizeof(struct tld_protocols) + size * sizeof(uint32_t) + length + 1));
+    if(protocols == nullptr)
+    {
+        return nullptr;
+    }
+    protocols->f_mask = static_cast<uint32_t>(size - 1);
+    protocols->f_slots = reinterpret_cast<uint32_t *>(protocols + 1);
+    protocols->f_names = reinterpret_cast<char *>(protocols->f_slots + size);
+
+    names = protocols->f_names;
+    for(q = list; *q != '\0'; q = *e == ',' ? e + 1 : e)
+    {
+        for(e = q; *e != '\0' && *e != ','; ++e);
+        n = static_cast<int>(e - q);
+        if(n == 0)
+        {
+            continue;
+        }
+        if(n == 1 && *q == '*')
+        {
+            protocols->f_any = 1;
+            continue;
+        }
+        if(match_protocol(protocols, q, n) != 0)
+        {
+            /* duplicate */
+            continue;
+        }
+        for(idx = hash_protocol(q, n) & protocols->f_mask;
+            protocols->f_slots[idx] != 0;
+            idx = (idx + 1) & protocols->f_mask);
+        protocols->f_slots[idx] = static_cast<uint32_t>(names - protocols->f_names + 1);
+        for(; q < e; ++q, ++names)
+        {
+            *names = static_cast<char>(tolower(*q));
+        }
+        *names++ = '\0';
+    }
+
+    return protocols;
+}
+
+
+/** \brief Free the protocols compiled by tld_protocols_compile().
+ *
+ * This function releases the compiled protocols. The pointer cannot be
+ * used anymore once this function returns.
+ *
+ * \param[in] protocols  The protocols to release, may be NULL.
+ */
+void tld_protocols_free(struct tld_protocols * protocols)
+{
+    free(protocols);
+}
+
+
 /** \brief Return the version of the library.
  *
  * This functino returns the version of this library. The version
@@ -1673,16 +4306,24 @@ uint32_t tld_get_static_tlds_buffer_size()
 
 
 int tld_tag_count(struct tld_info *info)
+{
+    default_context const context;
+    return tld_ctx_tag_count(context.get(), info);
+}
+
+
+int tld_ctx_tag_count(struct tld_context const * context, struct tld_info *info)
 {
     const struct tld_description *tld;
 
-    if(info == nullptr
+    if(context == nullptr
+    || info == nullptr
     || info->f_tld_index < 0)
     {
         return -1;
     }
 
-    tld = tld_file_description(g_tld_file, info->f_tld_index);
+    tld = tld_file_description(context->f_file, info->f_tld_index);
     if(tld == nullptr)
     {
         return -1;
@@ -1693,6 +4334,13 @@ int tld_tag_count(struct tld_info *info)
 
 
 enum tld_result tld_get_tag(struct tld_info *info, int tag_idx, struct tld_tag_definition *tag)
+{
+    default_context const context;
+    return tld_ctx_get_tag(context.get(), info, tag_idx, tag);
+}
+
+
+enum tld_result tld_ctx_get_tag(struct tld_context const * context, struct tld_info *info, int tag_idx, struct tld_tag_definition *tag)
 {
     const struct tld_description *tld;
     const tld_tag *file_tag;
@@ -1718,28 +4366,28 @@ enum tld_result tld_get_tag(struct tld_info *info, int tag_idx, struct tld_tag_d
         return TLD_RESULT_INVALID;
     }
 
-    result = tld_load_tlds_if_not_loaded();
+    result = context_ready(context);
     if(result != TLD_RESULT_SUCCESS)
     {
         return result;
     }
 
-    tld = tld_file_description(g_tld_file, info->f_tld_index);
+    tld = tld_file_description(context->f_file, info->f_tld_index);
     if(tld == nullptr)
     {
         return TLD_RESULT_NOT_FOUND;
     }
 
-    file_tag = tld_file_tag(g_tld_file, tld->f_tags + tag_idx * 2);
+    file_tag = tld_file_tag(context->f_file, tld->f_tags + tag_idx * 2);
     if(file_tag == nullptr)
     {
         return TLD_RESULT_NOT_FOUND;
     }
 
-    tag->f_name = tld_file_string(g_tld_file, file_tag->f_tag_name, &l);
+    tag->f_name = tld_file_string(context->f_file, file_tag->f_tag_name, &l);
     tag->f_name_length = l;
 
-    tag->f_value = tld_file_string(g_tld_file, file_tag->f_tag_value, &l);
+    tag->f_value = tld_file_string(context->f_file, file_tag->f_tag_value, &l);
     tag->f_value_length = l;
 
     if(tag->f_name == nullptr
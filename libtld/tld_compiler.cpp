@@ -48,8 +48,10 @@
 // C
 //
 #include    <dirent.h>
+#include    <stdio.h>
 #include    <string.h>
 #include    <sys/stat.h>
+#include    <unistd.h>
 
 
 
@@ -2719,22 +2721,53 @@ void tld_compiler::output_tlds(std::ostream & out)
 
 void tld_compiler::save_to_file(std::string const & buffer)
 {
-    std::ofstream out;
-    out.open(f_output);
-    if(!out)
+    // the library maps the output file in memory, so we never overwrite
+    // it in place; instead we save a new file and rename it
+    //
+    std::string const tmp(f_output + ".tmp");
+    {
+        std::ofstream out;
+        out.open(tmp);
+        if(!out)
+        {
+            f_errno = errno;
+            f_errmsg = "error: could not open output file \""
+                     + tmp
+                     + "\", errno: "
+                     + std::to_string(f_errno)
+                     + ", "
+                     + strerror(f_errno)
+                     + ".";
+            return;
+        }
+
+        out.write(buffer.c_str(), buffer.length());
+        out.close();
+        if(!out)
+        {
+            f_errno = errno;
+            f_errmsg = "error: could not write output file \""
+                     + tmp
+                     + "\".";
+            unlink(tmp.c_str());
+            return;
+        }
+    }
+
+    if(rename(tmp.c_str(), f_output.c_str()) != 0)
     {
         f_errno = errno;
-        f_errmsg = "error: could not open output file \""
+        f_errmsg = "error: could not rename \""
+                 + tmp
+                 + "\" to \""
                  + f_output
                  + "\", errno: "
                  + std::to_string(f_errno)
                  + ", "
                  + strerror(f_errno)
                  + ".";
-        return;
+        unlink(tmp.c_str());
     }
-
-    out.write(buffer.c_str(), buffer.length());
 }
 
 
@@ -2798,9 +2831,9 @@ void tld_compiler::output_header(std::ostream & out)
            " * currently assigned TLDs (all countries plus international or common TLDs.)\n"
            " *\n"
            " * In this new implementation, the C version to compile is actually the\n"
-           " * RIFF/TLDS binary. We load it with the tld_file_load() function as if it\n"
-           " * were on disk. This way we have exactly the same code to load the\n"
-           " * compiled-in and the TLDs from files.\n"
+           " * RIFF/TLDS binary. We load it with the tld_file_load_buffer() function\n"
+           " * which verifies it exactly like a file on disk and then uses the data\n"
+           " * in place.\n"
            " */\n"
            "#include <stdint.h>\n";
 }
@@ -2832,7 +2865,12 @@ void tld_compiler::save_to_c_file(std::string const & buffer)
 
     output_header(out);
 
-    out << "uint8_t const tld_static_tlds[] = {\n"
+    // the library uses this array in place so it has to be aligned
+    //
+    out << "#ifdef __GNUC__\n"
+           "__attribute__((aligned(8)))\n"
+           "#endif\n"
+           "uint8_t const tld_static_tlds[] = {\n"
         << std::hex
         << std::setfill('0');
 
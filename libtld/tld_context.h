@@ -0,0 +1,48 @@
+/* Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef LIB_TLD_CONTEXT_H
+#define LIB_TLD_CONTEXT_H
+/** \file
+ * \brief Internal functions of the default context.
+ *
+ * These functions are defined in tld.cpp and used by the other parts
+ * of the library. They are not part of the public API and this header
+ * does not get installed.
+ */
+
+#include "libtld/tld.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern enum tld_result  tld_default_context_ready(); // defined in tld.cpp
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+//#ifndef LIB_TLD_CONTEXT_H
+// vim: ts=4 sw=4 et
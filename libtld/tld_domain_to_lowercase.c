@@ -485,47 +485,97 @@ static int tld_wctomb(wint_t wc, char **s, int *max_length)
  *
  * \return A pointer to the resulting conversion, NULL if the buffer
  *         cannot be allocated or the input data is considered invalid.
+ *
+ * \sa tld_domain_to_lowercase_buffer()
  */
 char *tld_domain_to_lowercase(const char *domain)
 {
-    int len = (domain == (const char *) 0 ? 0 : strlen(domain) * 2);
-    wint_t wc;
+    size_t size = (domain == (const char *) 0 ? 0 : strlen(domain) * 2);
     char *result;
-    char *output;
 
-    if(len == 0)
+    if(size == 0)
     {
         return (char *) 0;
     }
 
     // we cannot change the input buffer, plus our result may be longer
     // than the input...
-    result = (char *) malloc(len + 1);
+    result = (char *) malloc(size + 1);
     if(result == (char *) 0)
     {
         return (char *) 0; // LCOV_EXCL_LINE
     }
 
-    output = result;
+    if(tld_domain_to_lowercase_buffer(domain, result, size + 1) < 0)
+    {
+        free(result);
+        return (char *) 0;
+    }
+
+    return result;
+}
+
+
+/** \brief Transform a domain to lowercase in the specified buffer.
+ *
+ * This function works like tld_domain_to_lowercase() except that the
+ * result is saved in the \p output buffer instead of a newly allocated
+ * buffer. This is useful when you have to convert many domains since
+ * you can reuse the same buffer each time.
+ *
+ * The result is never more than twice the length of the input. So an
+ * \p output buffer of at least 2 * strlen(domain) + 1 bytes gives you
+ * the same results as tld_domain_to_lowercase(). A smaller buffer may
+ * cause the function to fail.
+ *
+ * \param[in] domain  The input domain to convert to lowercase.
+ * \param[out] output  The buffer where the result gets saved.
+ * \param[in] size  The size of the \p output buffer in bytes, including
+ *                  space for the null terminator.
+ *
+ * \return The length of the result, not including the null terminator,
+ *         or -1 if the input data is considered invalid or the buffer
+ *         is too small.
+ */
+int tld_domain_to_lowercase_buffer(const char *domain, char *output, size_t size)
+{
+    int len;
+    wint_t wc;
+    char *result;
+
+    if(domain == (const char *) 0 || output == (char *) 0 || size == 0)
+    {
+        return -1;
+    }
+
+    len = strlen(domain) * 2;
+    if(len == 0)
+    {
+        return -1;
+    }
+    if((size_t) len >= size)
+    {
+        len = size - 1;
+    }
+
+    result = output;
     for(;;)
     {
         wc = tld_mbtowc(&domain);
         // wint_t is expected to be unsigned so we need a cast here
         if((int) wc == -1)
         {
-            free(result);
-            return (char *) 0;
+            return -1;
         }
         if(wc == L'\0')
         {
             *output = '\0';
-            return result;
+            return output - result;
         }
         if(tld_wctomb(wc, &output, &len) != 0)
         {
             // could not encode; buffer is probably full
-            free(result);
-            return (char *) 0;
+            return -1;
         }
     }
     /*NOTREACHED*/
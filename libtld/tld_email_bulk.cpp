@@ -0,0 +1,607 @@
+/* TLD library -- bulk validation of emails
+ * Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** \file
+ * \brief Implementation of the bulk validation of emails.
+ *
+ * This file includes the tld_email_bulk class and the corresponding C
+ * functions. These are used to validate very large lists of emails,
+ * such as a mailing list import, using multiple threads.
+ */
+
+#include "libtld/tld.h"
+#include "libtld/tld_context.h"
+
+// C++
+//
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <thread>
+
+
+namespace
+{
+/** \brief The minimum number of bytes handled by one thread.
+ *
+ * Starting a thread is not free. Small buffers are validated with
+ * fewer threads so that each thread has at least this much work.
+ */
+size_t const MIN_BYTES_PER_THREAD = 64 * 1024;
+
+/** \brief The size of a block of canonicalized emails.
+ *
+ * Each worker saves the strings that cannot point to the input buffer
+ * in blocks of this size.
+ */
+size_t const BLOCK_SIZE = 64 * 1024;
+
+/** \brief Check whether a character ends an email.
+ *
+ * \param[in] c  The character to check.
+ *
+ * \return true if \p c is a new line or a null character.
+ */
+bool is_separator(char c)
+{
+    return c == '\n' || c == '\0';
+}
+
+/** \brief Check whether a line only includes white spaces.
+ *
+ * \param[in] s  The start of the line.
+ * \param[in] e  The end of the line.
+ *
+ * \return true if the line is empty or only includes spaces, tabs, and
+ * carriage returns.
+ */
+bool is_blank(char const * s, char const * e)
+{
+    for(; s < e && (*s == ' ' || *s == '\t' || *s == '\r'); ++s);
+    return s == e;
+}
+
+/** \brief Check whether a span points to the specified buffer.
+ *
+ * \param[in] span  The span to check.
+ * \param[in] start  The start of the buffer.
+ * \param[in] end  The end of the buffer.
+ *
+ * \return true if the whole span is inside the buffer.
+ */
+bool in_buffer(tld_string_span const & span, char const * start, char const * end)
+{
+    std::less_equal<char const *> le;
+    return le(start, span.f_start) && le(span.f_start + span.f_length, end);
+}
+} // no name namespace
+
+
+/** \class tld_email_bulk
+ * \brief Validate a large number of emails using multiple threads.
+ *
+ * This class validates a buffer of emails, one per line. The lines are
+ * separated by new line ('\\n') or null ('\\0') characters. The buffer is
+ * cut in one chunk per thread and each thread parses its chunk with its
+ * own tld_email_list object.
+ *
+ * The results are saved in one array with exactly one result per line,
+ * in the order of the lines. Each result includes the value returned by
+ * the parser, the domain, and the canonicalized email. The results are
+ * the same whatever the number of threads used.
+ *
+ * The domain and the canonicalized email are spans. Most of the time
+ * they point directly in the input buffer. When they had to be rewritten
+ * (i.e. the domain includes uppercase characters) they point to a buffer
+ * owned by this object.
+ *
+ * The object can be reused to validate many buffers. Its buffers are
+ * kept between calls.
+ *
+ * \sa tld_email_list
+ */
+
+/** \brief Initialize the bulk validator.
+ *
+ * By default the validator uses one thread per processor.
+ */
+tld_email_bulk::tld_email_bulk()
+{
+}
+
+/** \brief Set the number of threads used to validate emails.
+ *
+ * The validate() function uses up to \p count threads, including the
+ * calling thread. Small buffers use fewer threads.
+ *
+ * \param[in] count  The number of threads. If 0 or negative, the number
+ *                   of processors is used.
+ */
+void tld_email_bulk::set_thread_count(int count)
+{
+    f_thread_count = std::max(count, 0);
+}
+
+/** \brief Get the number of threads used to validate emails.
+ *
+ * \return The number of threads the validate() function uses with a
+ * large buffer.
+ */
+int tld_email_bulk::thread_count() const
+{
+    if(f_thread_count > 0)
+    {
+        return f_thread_count;
+    }
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+/** \brief Set the size of the cache of domains of each thread.
+ *
+ * Each thread uses its own tld_email_list object. This function sets the
+ * size of the cache of domains of those objects. See
+ * tld_email_list::set_domain_cache_size() for details.
+ *
+ * \param[in] size  The maximum number of domains kept in each cache.
+ */
+void tld_email_bulk::set_domain_cache_size(size_t size)
+{
+    f_domain_cache_size = size;
+    for(auto & w : f_workers)
+    {
+        w.f_list.set_domain_cache_size(size);
+    }
+}
+
+/** \brief Run a function on each worker.
+ *
+ * The function runs with the first worker in the calling thread and
+ * with the other workers in new threads. Then it waits for all the
+ * threads to be done.
+ *
+ * If the function throws, the exception is raised again once all the
+ * threads are done.
+ *
+ * \param[in] f  The function to run with each worker.
+ */
+template<typename F>
+void tld_email_bulk::run_workers(F f)
+{
+    std::vector<std::exception_ptr> exceptions(f_workers.size());
+    auto run = [&f, &exceptions](worker_t & w, size_t idx)
+        {
+            try
+            {
+                f(w);
+            }
+            catch(...)
+            {
+                exceptions[idx] = std::current_exception();
+            }
+        };
+
+    std::vector<std::thread> threads;
+    threads.reserve(f_workers.size());
+    for(size_t idx(1); idx < f_workers.size(); ++idx)
+    {
+        threads.emplace_back(run, std::ref(f_workers[idx]), idx);
+    }
+    run(f_workers[0], 0);
+    for(auto & t : threads)
+    {
+        t.join();
+    }
+
+    for(auto const & e : exceptions)
+    {
+        if(e != nullptr)
+        {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+/** \brief Validate a buffer of emails.
+ *
+ * This function validates all the emails found in \p buffer. The buffer
+ * includes one email per line. The lines end with a new line ('\\n') or
+ * a null ('\\0') character. The last line does not need to end with a
+ * separator. Carriage returns and other white spaces around the emails
+ * are ignored like in tld_email_list::parse().
+ *
+ * Each line gets one result, in the same order as the lines:
+ *
+ * \li An empty line, or a line with only white spaces (i.e. the '\\r'
+ * of an empty line ending with "\\r\\n"), gets TLD_RESULT_NULL.
+ * \li A line which includes exactly one email (and no group) gets the
+ * value returned by tld_email_list::parse() for that line.
+ * \li A line which the parser accepts but which does not include exactly
+ * one email (i.e. a list of emails or a group) gets TLD_RESULT_INVALID.
+ *
+ * When the result is TLD_RESULT_SUCCESS, the f_domain and
+ * f_canonicalized_email spans are set to the same values as
+ * tld_email_list::next() returns. Otherwise both spans are null.
+ *
+ * \warning
+ * The spans may point in \p buffer. They remain valid until \p buffer
+ * gets modified or released, or this object gets destroyed or validates
+ * another buffer.
+ *
+ * \exception std::logic_error
+ * The parser raises this exception if it finds an invalid character
+ * which it should have caught earlier. If any thread raises an
+ * exception, it is raised again by this function once all the threads
+ * are done.
+ *
+ * \param[in] buffer  The emails to validate.
+ * \param[in] size  The size of \p buffer in bytes.
+ * \param[in] flags  The flags passed to the parser.
+ *
+ * \return TLD_RESULT_SUCCESS if all the emails are valid,
+ * TLD_RESULT_INVALID if at least one email is not valid, and
+ * TLD_RESULT_NULL if \p buffer is a null pointer. If the TLDs cannot be
+ * loaded, the error returned by tld_load_tlds() is returned and no line
+ * gets validated.
+ *
+ * \sa results()
+ */
+tld_result tld_email_bulk::validate(char const * buffer, size_t size, int flags)
+{
+    f_results.clear();
+    if(buffer == nullptr)
+    {
+        return TLD_RESULT_NULL;
+    }
+
+    // the TLDs of the default context must be loaded before we start
+    // the threads (see g_tld_context)
+    //
+    tld_result const ready(tld_default_context_ready());
+    if(ready != TLD_RESULT_SUCCESS)
+    {
+        return ready;
+    }
+
+    size_t const thread_count(std::max(std::min(
+                  static_cast<size_t>(this->thread_count())
+                , size / MIN_BYTES_PER_THREAD), static_cast<size_t>(1)));
+    if(f_workers.size() != thread_count)
+    {
+        f_workers.resize(thread_count);
+        for(auto & w : f_workers)
+        {
+            if(w.f_list.domain_cache_size() != f_domain_cache_size)
+            {
+                w.f_list.set_domain_cache_size(f_domain_cache_size);
+            }
+        }
+    }
+
+    // cut the buffer in chunks which end right after a separator
+    //
+    char const * const end(buffer + size);
+    char const * start(buffer);
+    for(size_t idx(0); idx < thread_count; ++idx)
+    {
+        worker_t & w(f_workers[idx]);
+        w.f_start = start;
+        if(idx + 1 == thread_count)
+        {
+            w.f_end = end;
+        }
+        else
+        {
+            char const * s(std::max(start, buffer + size / thread_count * (idx + 1)));
+            for(; s < end && !is_separator(*s); ++s);
+            w.f_end = s < end ? s + 1 : end;
+        }
+        start = w.f_end;
+    }
+
+    // count the lines of each chunk
+    //
+    run_workers([](worker_t & w)
+        {
+            size_t count(0);
+            for(char const * s(w.f_start); s < w.f_end; ++s)
+            {
+                count += is_separator(*s) ? 1 : 0;
+            }
+            if(w.f_end > w.f_start && !is_separator(w.f_end[-1]))
+            {
+                // last line without a separator
+                //
+                ++count;
+            }
+            w.f_count = count;
+        });
+
+    size_t total(0);
+    for(auto & w : f_workers)
+    {
+        w.f_first = total;
+        total += w.f_count;
+    }
+    f_results.resize(total);
+
+    // validate the emails, each worker writes its own results
+    //
+    run_workers([this, flags](worker_t & w)
+        {
+            w.f_block = 0;
+            for(auto & b : w.f_blocks)
+            {
+                b.clear();
+            }
+            w.f_invalid = 0;
+
+            tld_email_bulk_result * r(f_results.data() + w.f_first);
+            for(char const * s(w.f_start); s < w.f_end; ++r)
+            {
+                char const * e(s);
+                for(; e < w.f_end && !is_separator(*e); ++e);
+
+                r->f_domain = tld_string_span();
+                r->f_canonicalized_email = tld_string_span();
+                if(is_blank(s, e))
+                {
+                    r->f_result = TLD_RESULT_NULL;
+                }
+                else
+                {
+                    r->f_result = w.f_list.parse_views(s, e - s, flags);
+                    if(r->f_result == TLD_RESULT_SUCCESS)
+                    {
+                        tld_email_view view;
+                        if(w.f_list.count() != 1
+                        || !w.f_list.next(&view)
+                        || view.f_group.f_length != 0)
+                        {
+                            r->f_result = TLD_RESULT_INVALID;
+                        }
+                        else
+                        {
+                            r->f_domain = view.f_domain;
+                            if(!in_buffer(r->f_domain, s, e))
+                            {
+                                r->f_domain.f_start = w.save(r->f_domain.f_start, r->f_domain.f_length);
+                            }
+                            r->f_canonicalized_email = view.f_canonicalized_email;
+                            if(!in_buffer(r->f_canonicalized_email, s, e))
+                            {
+                                r->f_canonicalized_email.f_start = w.save(r->f_canonicalized_email.f_start, r->f_canonicalized_email.f_length);
+                            }
+                        }
+                    }
+                }
+                if(r->f_result != TLD_RESULT_SUCCESS)
+                {
+                    ++w.f_invalid;
+                }
+
+                s = e + 1;
+            }
+        });
+
+    for(auto const & w : f_workers)
+    {
+        if(w.f_invalid != 0)
+        {
+            return TLD_RESULT_INVALID;
+        }
+    }
+
+    return TLD_RESULT_SUCCESS;
+}
+
+/** \brief Get the number of results.
+ *
+ * \return The number of lines found by the last call to validate().
+ */
+size_t tld_email_bulk::count() const
+{
+    return f_results.size();
+}
+
+/** \brief Get the results.
+ *
+ * The array includes count() results, one per line found by the last
+ * call to validate().
+ *
+ * \return A pointer to the first result.
+ */
+tld_email_bulk_result const * tld_email_bulk::results() const
+{
+    return f_results.data();
+}
+
+/** \brief Save a string in the blocks of this worker.
+ *
+ * The strings which cannot point to the input buffer get saved in
+ * blocks. A block never grows past its initial capacity so the
+ * returned pointers remain valid until the next validation.
+ *
+ * \param[in] str  The string to save.
+ * \param[in] length  The number of characters in \p str.
+ *
+ * \return A pointer to the copy of the string.
+ */
+char const * tld_email_bulk::worker_t::save(char const * str, size_t length)
+{
+    std::vector<char> * block(f_block < f_blocks.size() ? &f_blocks[f_block] : nullptr);
+    if(block == nullptr
+    || block->capacity() - block->size() < length)
+    {
+        if(block != nullptr)
+        {
+            // the strings in the current block are in use, use the next one
+            //
+            ++f_block;
+        }
+        if(f_block >= f_blocks.size())
+        {
+            f_blocks.emplace_back();
+        }
+        block = &f_blocks[f_block];
+        block->clear();
+        block->reserve(std::max(BLOCK_SIZE, length));
+    }
+
+    char const * result(block->data() + block->size());
+    block->insert(block->end(), str, str + length);
+    return result;
+}
+
+
+/** \brief Allocate a bulk validator.
+ *
+ * This function allocates a tld_email_bulk object which can be used to
+ * validate large buffers of emails. Release it with
+ * tld_email_bulk_free().
+ *
+ * \return A pointer to a new bulk validator.
+ *
+ * \sa tld_email_bulk_free()
+ */
+struct tld_email_bulk *tld_email_bulk_alloc()
+{
+    return new tld_email_bulk;
+}
+
+/** \brief Free a bulk validator.
+ *
+ * This function frees a bulk validator allocated with
+ * tld_email_bulk_alloc(). The results become invalid.
+ *
+ * \param[in] bulk  The bulk validator to release.
+ */
+void tld_email_bulk_free(struct tld_email_bulk * bulk)
+{
+    delete bulk;
+}
+
+/** \brief Set the number of threads used to validate emails.
+ *
+ * \param[in] bulk  The bulk validator.
+ * \param[in] count  The number of threads, 0 for one per processor.
+ *
+ * \sa tld_email_bulk::set_thread_count()
+ */
+void tld_email_bulk_set_thread_count(struct tld_email_bulk * bulk, int count)
+{
+    bulk->set_thread_count(count);
+}
+
+/** \brief Set the size of the cache of domains of each thread.
+ *
+ * \param[in] bulk  The bulk validator.
+ * \param[in] size  The maximum number of domains kept in each cache.
+ *
+ * \sa tld_email_bulk::set_domain_cache_size()
+ */
+void tld_email_bulk_set_domain_cache_size(struct tld_email_bulk * bulk, size_t size)
+{
+    bulk->set_domain_cache_size(size);
+}
+
+/** \brief Validate a buffer of emails.
+ *
+ * This function validates the emails found in \p buffer, one per line.
+ * See tld_email_bulk::validate() for details.
+ *
+ * \param[in] bulk  The bulk validator.
+ * \param[in] buffer  The emails to validate.
+ * \param[in] size  The size of \p buffer in bytes.
+ * \param[in] flags  The flags passed to the parser.
+ *
+ * \return TLD_RESULT_SUCCESS if all the emails are valid.
+ */
+enum tld_result tld_email_bulk_validate(struct tld_email_bulk * bulk, char const * buffer, size_t size, int flags)
+{
+    return bulk->validate(buffer, size, flags);
+}
+
+/** \brief Get the number of results.
+ *
+ * \param[in] bulk  The bulk validator.
+ *
+ * \return The number of lines found by the last validation.
+ */
+size_t tld_email_bulk_count(struct tld_email_bulk * bulk)
+{
+    return bulk->count();
+}
+
+/** \brief Get the results of the last validation.
+ *
+ * \param[in] bulk  The bulk validator.
+ *
+ * \return A pointer to an array of tld_email_bulk_count() results.
+ */
+struct tld_email_bulk_result const * tld_email_bulk_results(struct tld_email_bulk * bulk)
+{
+    return bulk->results();
+}
+
+
+/** \struct tld_email_bulk_result
+ * \brief The result of the validation of one email.
+ *
+ * The tld_email_bulk::validate() function generates one of these per
+ * line. The spans are not null terminated.
+ */
+
+/** \var tld_email_bulk_result::f_result
+ * \brief The result of the parser for this line.
+ */
+
+/** \var tld_email_bulk_result::f_domain
+ * \brief The domain of the email, as found in the email.
+ */
+
+/** \var tld_email_bulk_result::f_canonicalized_email
+ * \brief The canonicalized version of the email.
+ */
+
+/** \var tld_email_bulk::f_thread_count
+ * \brief The number of threads, 0 for one per processor.
+ */
+
+/** \var tld_email_bulk::f_domain_cache_size
+ * \brief The size of the cache of domains of each worker.
+ */
+
+/** \var tld_email_bulk::f_workers
+ * \brief The state of each thread.
+ *
+ * Each worker has its own tld_email_list object and blocks so the
+ * threads never share any parser state. The workers are kept between
+ * calls to validate() so their buffers get reused.
+ */
+
+/** \var tld_email_bulk::f_results
+ * \brief The results of the last validation, one per line.
+ */
+
+/* vim: ts=4 sw=4 et
+ */
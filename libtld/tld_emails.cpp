@@ -27,6 +27,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // C++
 //
 #include <memory>
@@ -284,33 +288,136 @@
 
 namespace
 {
-/** \brief Internal function used to trim a string.
+/** \brief The classes of the characters found in a list of emails.
+ *
+ * The parser uses these classes to jump from one structural character
+ * to the next. The g_email_class table gives the classes of each one
+ * of the 256 possible bytes.
+ */
+int const EMAIL_CLASS_ATOM      = 0x01;    // [A-Za-z0-9] and "!#$%&'*+-/=?^_`{|}~"
+int const EMAIL_CLASS_LIST      = 0x02;    // ',', ';', ':', '"', '(', and '['
+int const EMAIL_CLASS_SEPARATOR = 0x04;    // ',', ';', and ':'
+int const EMAIL_CLASS_QUOTED    = 0x08;    // '"' and '\\'
+int const EMAIL_CLASS_COMMENT   = 0x10;    // '(', ')', and '\\'
+int const EMAIL_CLASS_LITERAL   = 0x20;    // '[', ']', and '\\'
+
+
+/** \brief The class of each byte.
+ *
+ * See the EMAIL_CLASS_... values for details.
+ */
+unsigned char const g_email_class[256] =
+{
+    /* 0x00 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0x10 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0x20 */ 0x00, 0x01, 0x0A, 0x01, 0x01, 0x01, 0x01, 0x01, 0x12, 0x10, 0x01, 0x01, 0x06, 0x01, 0x00, 0x01,
+    /* 0x30 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x06, 0x06, 0x00, 0x01, 0x00, 0x01,
+    /* 0x40 */ 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    /* 0x50 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x22, 0x38, 0x20, 0x01, 0x01,
+    /* 0x60 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    /* 0x70 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+    /* 0x80 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0x90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0xA0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0xB0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0xC0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0xD0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0xE0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* 0xF0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+
+/** \brief Skip the characters which do not require special handling.
+ *
+ * This function returns a pointer to the first character between \p s
+ * and \p end which has one of the \p stop classes. If no such character
+ * is found, the function returns \p end.
+ *
+ * The headers of mailing list messages can be very long and only a few
+ * of their characters end an email, a quoted string, or a comment. When
+ * SSE2 is available, this function checks 16 characters at a time.
  *
- * This function is used to remove any white spaces (\\r, \\n, \\t, and
- * spaces (\\x20)) from the end of the string passed in as a parameter.
+ * \note
+ * With SSE2, the EMAIL_CLASS_ATOM class is not supported in \p stop.
  *
- * The function makes use of the resize() function if any character
- * need to be removed.
+ * \param[in] s  The first character to check.
+ * \param[in] end  The end of the list of emails (exclusive).
+ * \param[in] stop  The EMAIL_CLASS_... of the characters to stop at.
  *
- * \param[in,out] value  The string to be trimmed
+ * \return A pointer to the first character to be handled or \p end.
  */
-void trim(std::string& value)
+char const * skip_email_characters(char const * s, char const * end, int stop)
 {
-    if(!value.empty())
+#ifdef __SSE2__
+    if(end - s >= 16)
     {
-        size_t i(value.length());
-        for(; i > 0; --i)
+        __m128i const zero(_mm_setzero_si128());
+        do
         {
-            const char c(value[i - 1]);
-            if(c != ' ' && c != '\r' && c != '\n' && c != '\t')
+            __m128i const v(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s)));
+            __m128i m(zero);
+            if((stop & (EMAIL_CLASS_LIST | EMAIL_CLASS_SEPARATOR)) != 0)
             {
-                break;
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(';')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
             }
+            if((stop & (EMAIL_CLASS_QUOTED | EMAIL_CLASS_COMMENT | EMAIL_CLASS_LITERAL)) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+            }
+            if((stop & (EMAIL_CLASS_LIST | EMAIL_CLASS_QUOTED)) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+            }
+            if((stop & (EMAIL_CLASS_LIST | EMAIL_CLASS_COMMENT)) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('(')));
+            }
+            if((stop & EMAIL_CLASS_COMMENT) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(')')));
+            }
+            if((stop & (EMAIL_CLASS_LIST | EMAIL_CLASS_LITERAL)) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('[')));
+            }
+            if((stop & EMAIL_CLASS_LITERAL) != 0)
+            {
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(']')));
+            }
+            int const mask(_mm_movemask_epi8(m));
+            if(mask != 0)
+            {
+                return s + __builtin_ctz(mask);
+            }
+            s += 16;
         }
-        value.resize(i);
+        while(end - s >= 16);
     }
+#endif
+
+    for(; s < end && (g_email_class[static_cast<unsigned char>(*s)] & stop) == 0; ++s);
+
+    return s;
 }
 
+
+/** \brief Skip white spaces.
+ *
+ * \param[in] s  The first character to check.
+ * \param[in] end  The end of the list of emails (exclusive).
+ *
+ * \return A pointer to the first character which is not a space, a
+ * new line, a carriage return, or a tab, or \p end.
+ */
+char const * skip_spaces(char const * s, char const * end)
+{
+    for(; s < end && (*s == ' ' || *s == '\n' || *s == '\r' || *s == '\t'); ++s);
+    return s;
+}
+
+
 /** \brief Check whether a character can be quoted.
  *
  * The quoted characters are visible characters and white spaces (space 0x20,
@@ -340,20 +447,259 @@ bool is_quoted_char(char c)
  */
 bool is_atom_char(char c)
 {
-    return (c >= 'A' && c <= 'Z')
-        || (c >= 'a' && c <= 'z')
-        || (c >= '0' && c <= '9')
-        || c == '!' || c == '#'
-        || c == '$' || c == '%'
-        || c == '&' || c == '\''
-        || c == '*' || c == '+'
-        || c == '-' || c == '/'
-        || c == '=' || c == '?'
-        || c == '^' || c == '_'
-        || c == '`' || c == '{'
-        || c == '|' || c == '}'
-        || c == '~';
+    return (g_email_class[static_cast<unsigned char>(c)] & EMAIL_CLASS_ATOM) != 0;
+}
+
+/** \brief Check whether a string has to be quoted.
+ *
+ * This function applies the rules described in the
+ * tld_email_list::quote_string() function to the \p length characters
+ * found at \p str. It returns true if that string has to be written
+ * between quotes.
+ *
+ * \param[in] str  The string to check, it does not need to be null
+ *                 terminated.
+ * \param[in] length  The number of characters in \p str.
+ * \param[in] quote  The type of quotes, see quote_string() for details.
+ *
+ * \return true if the string requires quotes.
+ */
+bool requires_quotes(char const * str, size_t length, char quote)
+{
+    char const * extra("");
+    switch(quote)
+    {
+    case '(':
+        return true;
+
+    case '"':
+        extra = " \t";
+        break;
+
+    case '\'':
+    case '[':
+        extra = ".";
+        break;
+
+    }
+    for(char const * end(str + length); str < end; ++str)
+    {
+        if(!is_atom_char(*str) && strchr(extra, *str) == nullptr)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** \brief Append a string to a buffer, with quotes if required.
+ *
+ * This function appends the \p length characters found at \p str to
+ * \p out. If requires_quotes() says so, the string is written between
+ * quotes and the characters that need to be are escaped with a
+ * backslash.
+ *
+ * \warning
+ * The \p str pointer may point inside the \p out buffer, in which case
+ * the caller must make sure that \p out has enough capacity to not
+ * get reallocated while appending.
+ *
+ * \param[in,out] out  The buffer receiving the string.
+ * \param[in] str  The string to append, it does not need to be null
+ *                 terminated.
+ * \param[in] length  The number of characters in \p str.
+ * \param[in] quote  The type of quotes, see quote_string() for details.
+ */
+void append_quoted(std::string & out, char const * str, size_t length, char quote)
+{
+    if(!requires_quotes(str, length, quote))
+    {
+        out.append(str, length);
+        return;
+    }
+
+    char open(quote);
+    char close('"');
+    char const * escape("");
+    switch(quote)
+    {
+    case '(':
+        close = ')';
+        escape = "()";
+        break;
+
+    case '"':
+        escape = "\"";
+        break;
+
+    case '\'':
+        open = '"';
+        escape = "\"";
+        break;
+
+    case '[':
+        close = ']';
+        break;
+
+    }
+    out += open;
+    for(char const * end(str + length); str < end; ++str)
+    {
+        if(strchr(escape, *str) != nullptr)
+        {
+            out += '\\';
+        }
+        out += *str;
+    }
+    out += close;
 }
+
+/** \brief A value being built by the email parser.
+ *
+ * The email parser builds values (display name, username, domain) one
+ * character at a time. As long as the characters are contiguous in the
+ * input, the value remains a span of the input. When a character gets
+ * skipped or rewritten (a backslash, a comment, white spaces collapsed
+ * to one space, etc.) the value gets copied to the arena and the
+ * following characters are appended there.
+ *
+ * Only the value being built grows so when it lives in the arena, it is
+ * always found at the very end of the arena.
+ */
+class value_t
+{
+public:
+    value_t(char const * source, std::string & arena)
+        : f_source(source)
+        , f_arena(&arena)
+    {
+    }
+
+    bool empty() const
+    {
+        return f_length == 0;
+    }
+
+    size_t length() const
+    {
+        return f_length;
+    }
+
+    size_t offset() const
+    {
+        return f_offset;
+    }
+
+    bool in_arena() const
+    {
+        return f_in_arena;
+    }
+
+    /** \brief Get a pointer to the value.
+     *
+     * The pointer is not valid anymore once more data gets added to
+     * the arena.
+     *
+     * \return A pointer to the characters of this value.
+     */
+    char const * data() const
+    {
+        return (f_in_arena ? f_arena->data() : f_source) + f_offset;
+    }
+
+    char back() const
+    {
+        return data()[f_length - 1];
+    }
+
+    void clear()
+    {
+        f_offset = 0;
+        f_length = 0;
+        f_in_arena = false;
+    }
+
+    /** \brief Append the input character found at \p s.
+     *
+     * If the character directly follows this value in the input, the
+     * span grows by one. Otherwise the character gets copied.
+     *
+     * \param[in] s  A pointer to a character of the input.
+     */
+    void append(char const * s)
+    {
+        if(f_length == 0)
+        {
+            f_offset = s - f_source;
+            f_length = 1;
+            f_in_arena = false;
+        }
+        else if(!f_in_arena && f_source + f_offset + f_length == s)
+        {
+            ++f_length;
+        }
+        else
+        {
+            append_char(*s);
+        }
+    }
+
+    void append_char(char c)
+    {
+        if(!f_in_arena)
+        {
+            size_t const offset(f_arena->length());
+            f_arena->append(f_source + f_offset, f_length);
+            f_offset = offset;
+            f_in_arena = true;
+        }
+        *f_arena += c;
+        ++f_length;
+    }
+
+    /** \brief Make the end of the arena this value.
+     *
+     * The value is set to the characters found in the arena from
+     * \p offset to the end of the arena.
+     *
+     * \param[in] offset  The offset of the first character of the value.
+     */
+    void set_arena_tail(size_t offset)
+    {
+        f_offset = offset;
+        f_length = f_arena->length() - offset;
+        f_in_arena = true;
+    }
+
+    /** \brief Remove white spaces from the end of the value.
+     *
+     * This function removes any white spaces (\\r, \\n, \\t, and
+     * spaces (\\x20)) from the end of the value.
+     */
+    void trim()
+    {
+        char const * s(data());
+        for(; f_length > 0; --f_length)
+        {
+            char const c(s[f_length - 1]);
+            if(c != ' ' && c != '\r' && c != '\n' && c != '\t')
+            {
+                break;
+            }
+        }
+        if(f_in_arena)
+        {
+            f_arena->resize(f_offset + f_length);
+        }
+    }
+
+private:
+    char const *        f_source = nullptr;
+    std::string *       f_arena = nullptr;
+    size_t              f_offset = 0;
+    size_t              f_length = 0;
+    bool                f_in_arena = false;
+};
 } // no name namespace
 
 
@@ -371,6 +717,59 @@ tld_email_list::tld_email_list()
 {
 }
 
+/** \brief Copy a tld_email_list object.
+ *
+ * This function copies \p rhs in this new object. See the assignment
+ * operator for details.
+ *
+ * \param[in] rhs  The list to copy.
+ */
+tld_email_list::tld_email_list(tld_email_list const & rhs)
+{
+    *this = rhs;
+}
+
+/** \brief Copy a tld_email_list object.
+ *
+ * This function copies all the results of \p rhs in this object.
+ *
+ * When \p rhs was filled by parse_views(), its spans point to the
+ * buffer of the caller. The copy does not keep a reference to that
+ * buffer. Instead it copies the input in its own buffer, as parse()
+ * does, so the copy remains valid once the buffer passed to
+ * parse_views() is gone. The views returned by next() on the copy
+ * point to that copy.
+ *
+ * \param[in] rhs  The list to copy.
+ *
+ * \return A reference to this object.
+ */
+tld_email_list & tld_email_list::operator = (tld_email_list const & rhs)
+{
+    if(this != &rhs)
+    {
+        if(rhs.f_source == nullptr)
+        {
+            f_input = rhs.f_input;
+        }
+        else
+        {
+            f_input.assign(rhs.f_source, rhs.f_source_length);
+        }
+        f_source = nullptr;
+        f_source_length = 0;
+        f_arena = rhs.f_arena;
+        f_flags = rhs.f_flags;
+        f_result = rhs.f_result;
+        f_pos = rhs.f_pos;
+        f_spans = rhs.f_spans;
+        f_strings = rhs.f_strings;
+        f_domain_cache = rhs.f_domain_cache;
+    }
+
+    return *this;
+}
+
 /** \brief Parse a new list of emails.
  *
  * This function parses the list of emails as specified by \p emails.
@@ -381,6 +780,9 @@ tld_email_list::tld_email_list()
  * Note that at this time it is not possible to only extra the list
  * of valid emails from a list of valid and invalid emails.
  *
+ * The \p emails string is copied in the list object so the results
+ * remain valid until the next call to parse() or parse_views().
+ *
  * \param[in] emails  A list of email address to be parsed.
  * \param[in] flags  A set of flags to define what should be checked
  *                   and what should be ignored. No flags are defined
@@ -388,31 +790,203 @@ tld_email_list::tld_email_list()
  *
  * \return TLD_RESULT_SUCCESS when no errors were detected, TLD_RESULT_INVALID
  *         or some other value if any error occured.
+ *
+ * \sa parse_views()
  */
 tld_result tld_email_list::parse(std::string const & emails, int flags)
 {
-    f_input = emails;
+    return parse(emails.c_str(), flags);
+}
+
+/** \brief Parse a new list of emails.
+ *
+ * This function works exactly like the parse() function taking an
+ * std::string. It is used by the C interface to avoid creating a
+ * temporary string on each call.
+ *
+ * \param[in] emails  A null terminated list of email address to be parsed.
+ * \param[in] flags  A set of flags to define what should be checked
+ *                   and what should be ignored. No flags are defined
+ *                   yet.
+ *
+ * \return TLD_RESULT_SUCCESS when no errors were detected, TLD_RESULT_INVALID
+ *         or some other value if any error occured.
+ */
+tld_result tld_email_list::parse(char const * emails, int flags)
+{
+    // assign() reuses the buffer of f_input
+    //
+    f_input.assign(emails == nullptr ? "" : emails);
+    parse_views(f_input.c_str(), flags);
+
+    // use f_input directly so a copy of this object remains valid
+    //
+    f_source = nullptr;
+    f_source_length = 0;
+
+    return f_result;
+}
+
+/** \brief Parse a new list of emails without copying it.
+ *
+ * This function parses the list of emails exactly like the parse()
+ * function, except that the \p emails string is not copied. Instead
+ * the results are saved as spans: most of the fields point directly
+ * in the \p emails string. The few fields which need to be rewritten
+ * (i.e. a domain forced to lowercase, a display name with comments
+ * removed, an email which requires quotes, etc.) are written to an
+ * arena which the list object owns.
+ *
+ * The results are retrieved with the next(tld_email_view *) function.
+ * The other next() functions can also be used, although these create
+ * strings for each email.
+ *
+ * Parsing a list of emails this way allocates the list of spans once
+ * and the arena at most a few times, whatever the number of emails.
+ *
+ * \warning
+ * The \p emails buffer must remain valid and unchanged until this list
+ * object is freed or a new list gets parsed. A copy of this list does
+ * not depend on that buffer: the copy includes its own copy of the
+ * input (see operator = ()).
+ *
+ * \param[in] emails  A null terminated list of email address to be parsed.
+ * \param[in] flags  A set of flags to define what should be checked
+ *                   and what should be ignored. No flags are defined
+ *                   yet.
+ *
+ * \return TLD_RESULT_SUCCESS when no errors were detected, TLD_RESULT_INVALID
+ *         or some other value if any error occured.
+ *
+ * \sa parse()
+ * \sa next(tld_email_view *)
+ */
+tld_result tld_email_list::parse_views(char const * emails, int flags)
+{
+    if(emails == nullptr)
+    {
+        emails = "";
+    }
+    return parse_views(emails, strlen(emails), flags);
+}
+
+/** \brief Parse a new list of emails without copying it.
+ *
+ * This function works like parse_views(char const *, int) except that
+ * the \p emails string does not need to be null terminated. This is
+ * useful to parse emails found in a larger buffer such as one line of
+ * a file.
+ *
+ * \note
+ * The \p emails string is not expected to include any '\\0'. The
+ * result is undefined if it does.
+ *
+ * \warning
+ * The \p emails buffer must remain valid and unchanged until this list
+ * object is freed or a new list gets parsed. A copy of this list does
+ * not depend on that buffer: the copy includes its own copy of the
+ * input (see operator = ()).
+ *
+ * \param[in] emails  A list of email address to be parsed.
+ * \param[in] length  The number of characters in \p emails.
+ * \param[in] flags  A set of flags to define what should be checked
+ *                   and what should be ignored. No flags are defined
+ *                   yet.
+ *
+ * \return TLD_RESULT_SUCCESS when no errors were detected, TLD_RESULT_INVALID
+ *         or some other value if any error occured.
+ */
+tld_result tld_email_list::parse_views(char const * emails, size_t length, int flags)
+{
+    if(emails == nullptr)
+    {
+        emails = "";
+        length = 0;
+    }
+    f_source = emails;
+    f_source_length = length;
     f_flags = flags;
     f_result = TLD_RESULT_SUCCESS;
-    f_last_group.clear();
     f_pos = 0; // always rewind too
-    f_email_list.clear();
+    f_spans.clear();
+    f_arena.clear();
+    f_strings.clear();
 
-    parse_all_emails();
+    // each ',', ';', and ':' ends at most one email or group
+    //
+    size_t max_items(1);
+    char const * const end(emails + length);
+    for(char const * s(skip_email_characters(emails, end, EMAIL_CLASS_SEPARATOR));
+        s < end;
+        s = skip_email_characters(s + 1, end, EMAIL_CLASS_SEPARATOR))
+    {
+        ++max_items;
+    }
+    f_spans.reserve(max_items);
+    f_arena.reserve((end - emails) * 2);
+
+    parse_all_emails(end);
     if(f_result != TLD_RESULT_SUCCESS)
     {
-        f_email_list.clear();
+        f_spans.clear();
     }
 
     return f_result;
 }
 
-/** \brief Parse all the emails in f_input.
+/** \brief Clear the list of emails.
+ *
+ * This function removes all the emails from the list. The list can
+ * then be reused with a new call to parse() or parse_views().
+ *
+ * The buffers are cleared but not released. A list which gets reused
+ * to parse many lists of emails quickly reaches a point where it
+ * does not need to allocate any more memory.
+ *
+ * \note
+ * The parse() and parse_views() functions call this function
+ * internally so you do not have to clear the list between calls.
+ * It is useful to not keep a reference to the last input.
+ */
+void tld_email_list::clear()
+{
+    f_input.clear();
+    f_source = nullptr;
+    f_source_length = 0;
+    f_flags = 0;
+    f_result = TLD_RESULT_SUCCESS;
+    f_pos = 0;
+    f_spans.clear();
+    f_arena.clear();
+    f_strings.clear();
+}
+
+/** \brief Get a pointer to the string being parsed.
  *
- * This function reads all the emails found in the f_input string. It
+ * The spans which are not in the arena are offsets in this string.
+ *
+ * \return The string passed to parse_views() or the copy of the string
+ * passed to parse().
+ */
+char const * tld_email_list::source() const
+{
+    return f_source == nullptr ? f_input.c_str() : f_source;
+}
+
+/** \brief Parse all the emails in the source.
+ *
+ * This function reads all the emails found in the source string. It
  * generates a list of emails segregated by group.
+ *
+ * The loop only stops on the characters which end an email or a group
+ * and on the characters which start a quoted string, a comment, or a
+ * domain literal. Everything else is skipped with
+ * skip_email_characters() which checks 16 characters at a time when
+ * SSE2 is available.
+ *
+ * \param[in] source_end  The end of the source string.
  */
-void tld_email_list::parse_all_emails()
+void tld_email_list::parse_all_emails(char const * source_end)
 {
     // old emails supposedly accepted \0 in headers!
     // we actually do not even support control characters as
@@ -421,24 +995,18 @@ void tld_email_list::parse_all_emails()
     // all the characters, only those necessary to cut all the
     // email elements properly
 
-    char const * start(f_input.c_str());
+    domain_cache_t * cache(f_domain_cache.f_entries.empty() ? nullptr : &f_domain_cache);
+
+    // skip leading spaces immediately
+    char const * start(skip_spaces(f_source, source_end));
     bool group(true);
-    char const * s(start);
-    for(; *s != '\0'; ++s)
+    span_t last_group;
+    for(char const * s(skip_email_characters(start, source_end, EMAIL_CLASS_LIST));
+        s < source_end;
+        s = skip_email_characters(s + 1, source_end, EMAIL_CLASS_LIST))
     {
         switch(*s)
         {
-        case ' ':
-        case '\n':
-        case '\r':
-        case '\t':
-            // skip leading spaces immediately
-            if(start == s)
-            {
-                start = s + 1;
-            }
-            break;
-
         case ';':
             // end of this group
             {
@@ -454,20 +1022,19 @@ void tld_email_list::parse_all_emails()
                 }
                 if(end - start > 0)
                 {
-                    std::string const e(start, end - start);
-                    tld_email_t email;
-                    email.f_group = f_last_group;
-                    f_result = email.parse(e);
+                    email_spans_t email;
+                    email.f_group = last_group;
+                    f_result = parse_email(f_source, start, end, f_arena, email, cache);
                     if(f_result != TLD_RESULT_SUCCESS)
                     {
                         return;
                     }
-                    f_email_list.push_back(email);
+                    f_spans.push_back(email);
                 }
             }
-            f_last_group = "";
+            last_group = span_t();
             group = true;
-            start = s + 1;
+            start = skip_spaces(s + 1, source_end);
             break;
 
         case ':':
@@ -495,21 +1062,20 @@ void tld_email_list::parse_all_emails()
                     f_result = TLD_RESULT_INVALID;
                     return;
                 }
-                std::string const last_group(start, end - start);
                 // always add the group with an empty email (in case there
                 // is no email; and it clearly delimit each group.)
-                tld_email_t email;
-                f_result = email.parse_group(last_group);
+                email_spans_t email;
+                f_result = parse_group_name(f_source, start, end, f_arena, email.f_group);
                 if(f_result != TLD_RESULT_SUCCESS)
                 {
                     // this happens if the group name is invalid
                     // (i.e. include controls or is empty)
                     return;
                 }
-                f_last_group = email.f_group;
-                f_email_list.push_back(email);
+                last_group = email.f_group;
+                f_spans.push_back(email);
             }
-            start = s + 1;
+            start = skip_spaces(s + 1, source_end);
             group = false; // cannot get another legal ':' until we find the ';'
             break;
 
@@ -528,37 +1094,36 @@ void tld_email_list::parse_all_emails()
                 }
                 if(end - start > 0)
                 {
-                    std::string const e(start, end - start);
-                    tld_email_t email;
-                    email.f_group = f_last_group;
-                    f_result = email.parse(e);
+                    email_spans_t email;
+                    email.f_group = last_group;
+                    f_result = parse_email(f_source, start, end, f_arena, email, cache);
                     if(f_result != TLD_RESULT_SUCCESS)
                     {
                         return;
                     }
-                    f_email_list.push_back(email);
+                    f_spans.push_back(email);
                 }
             }
-            start = s + 1;
+            start = skip_spaces(s + 1, source_end);
             break;
 
         case '"':
             // quoted strings may include escaped characters so it is a
             // special case, also it could include a comma
-            for(++s; *s != '\0' && *s != '"'; ++s)
+            for(s = skip_email_characters(s + 1, source_end, EMAIL_CLASS_QUOTED);
+                s < source_end && *s != '"';
+                s = skip_email_characters(s + 1, source_end, EMAIL_CLASS_QUOTED))
             {
-                if(*s == '\\')
+                // *s == '\\'
+                if(s + 1 >= source_end || !is_quoted_char(s[1]))
                 {
-                    if(!is_quoted_char(s[1]))
-                    {
-                        // "\NUL" is never considered valid
-                        f_result = TLD_RESULT_INVALID;
-                        return;
-                    }
-                    ++s;
+                    // "\NUL" is never considered valid
+                    f_result = TLD_RESULT_INVALID;
+                    return;
                 }
+                ++s;
             }
-            if(*s == '\0')
+            if(s >= source_end)
             {
                 // unterminated quoted string
                 f_result = TLD_RESULT_INVALID;
@@ -570,11 +1135,13 @@ void tld_email_list::parse_all_emails()
             {
                 // comments may include other comments
                 int comment_count(1);
-                for(++s; *s != '\0'; ++s)
+                for(s = skip_email_characters(s + 1, source_end, EMAIL_CLASS_COMMENT);
+                    s < source_end;
+                    s = skip_email_characters(s + 1, source_end, EMAIL_CLASS_COMMENT))
                 {
                     if(*s == '\\')
                     {
-                        if(!is_quoted_char(s[1]))
+                        if(s + 1 >= source_end || !is_quoted_char(s[1]))
                         {
                             // "\NUL" is never considered valid
                             f_result = TLD_RESULT_INVALID;
@@ -595,7 +1162,7 @@ void tld_email_list::parse_all_emails()
                         }
                     }
                 }
-                if(*s == '\0')
+                if(s >= source_end)
                 {
                     // unterminated comment
                     f_result = TLD_RESULT_INVALID;
@@ -605,16 +1172,14 @@ void tld_email_list::parse_all_emails()
             break;
 
         case '[':
-            for(++s; *s != ']'; ++s)
+            s = skip_email_characters(s + 1, source_end, EMAIL_CLASS_LITERAL);
+            if(s >= source_end || *s != ']')
             {
-                if(*s == '\0' || *s == '[' || *s == '\\')
-                {
-                    // domain literal cannot include '[', ']', or '\'
-                    // and it must end with ']'
-                    //
-                    f_result = TLD_RESULT_INVALID;
-                    return;
-                }
+                // domain literal cannot include '[', ']', or '\'
+                // and it must end with ']'
+                //
+                f_result = TLD_RESULT_INVALID;
+                return;
             }
             break;
 
@@ -630,7 +1195,7 @@ void tld_email_list::parse_all_emails()
 
     {
         // trim ending spaces
-        char const * end(s);
+        char const * end(source_end);
         for(; end > start; --end)
         {
             char const c(end[-1]);
@@ -641,15 +1206,14 @@ void tld_email_list::parse_all_emails()
         }
         if(end - start > 0)
         {
-            std::string const e(start, end - start);
-            tld_email_t email;
-            email.f_group = f_last_group;
-            f_result = email.parse(e);
+            email_spans_t email;
+            email.f_group = last_group;
+            f_result = parse_email(f_source, start, end, f_arena, email, cache);
             if(f_result != TLD_RESULT_SUCCESS)
             {
                 return;
             }
-            f_email_list.push_back(email);
+            f_spans.push_back(email);
         }
     }
 }
@@ -712,66 +1276,15 @@ void tld_email_list::parse_all_emails()
  */
 std::string tld_email_list::quote_string(const std::string& str, char quote)
 {
-    bool apply_quotes(false);
-    char open(quote);
-    char close('"');
-    char const * extra("");
-    char const * escape("");
-    switch(quote)
+    char const * s(str.c_str());
+    size_t const length(strlen(s));
+    if(!requires_quotes(s, length, quote))
     {
-    case '(':
-        close = ')';
-        apply_quotes = true;
-        escape = "()";
-        break;
-
-    case '"':
-        extra = " \t";
-        escape = "\"";
-        break;
-
-    case '\'':
-        open = '"';
-        close = '"';
-        extra = ".";
-        escape = "\"";
-        break;
-
-    case '[':
-        close = ']';
-        extra = ".";
-        break;
-
+        return str;
     }
-    if(!apply_quotes)
-    {
-        // check whether quotes are required
-        char const * s(str.c_str());
-        for(; *s != '\0'; ++s)
-        {
-            if(!is_atom_char(*s) && strchr(extra, *s) == nullptr)
-            {
-                break;
-            }
-        }
-        apply_quotes = *s != '\0';
-    }
-    if(apply_quotes)
-    {
-        std::string result;
-        result += open;
-        for(const char *s(str.c_str()); *s != '\0'; ++s)
-        {
-            if(strchr(escape, *s) != nullptr)
-            {
-                result += '\\';
-            }
-            result += *s;
-        }
-        result += close;
-        return result;
-    }
-    return str;
+    std::string result;
+    append_quoted(result, s, length, quote);
+    return result;
 }
 
 /** \brief Return the number of emails recorded.
@@ -787,7 +1300,7 @@ std::string tld_email_list::quote_string(const std::string& str, char quote)
  */
 int tld_email_list::count() const
 {
-    return static_cast<int>(f_email_list.size());
+    return static_cast<int>(f_spans.size());
 }
 
 /** \brief Rewind the reader to the start of the list.
@@ -803,66 +1316,265 @@ void tld_email_list::rewind() const
     f_pos = 0;
 }
 
-/** \brief Retrieve a copy of the next email information.
- *
- * This function reads the next email in your \p e parameter.
- *
- * The function returns true when the email parameter could be set. It
- * is very important that you check that return value because otherwise
- * you cannot actually know whether you reached the end of the list.
+/** \brief Retrieve a copy of the next email information.
+ *
+ * This function reads the next email in your \p e parameter.
+ *
+ * The function returns true when the email parameter could be set. It
+ * is very important that you check that return value because otherwise
+ * you cannot actually know whether you reached the end of the list.
+ *
+ * \param[out] e  The email object that receives the next item if there is one.
+ *
+ * \return true if e was set, false otherwise and e is not modified.
+ */
+bool tld_email_list::next(tld_email_t& e) const
+{
+    if(f_pos >= count())
+    {
+        return false;
+    }
+
+    // assign() reuses the buffers of e when it is reused
+    //
+    char const * s(source());
+    email_spans_t const & spans(f_spans[f_pos]);
+    auto set_string = [this, s](std::string & str, span_t const & span)
+        {
+            str.assign((span.f_arena ? f_arena.data() : s) + span.f_offset, span.f_length);
+        };
+    set_string(e.f_group,               spans.f_group);
+    set_string(e.f_original_email,      spans.f_original_email);
+    set_string(e.f_fullname,            spans.f_fullname);
+    set_string(e.f_username,            spans.f_username);
+    set_string(e.f_domain,              spans.f_domain);
+    set_string(e.f_email_only,          spans.f_email_only);
+    set_string(e.f_canonicalized_email, spans.f_canonicalized_email);
+    ++f_pos;
+
+    return true;
+}
+
+/** \brief Retrieve a copy of the next email information.
+ *
+ * This function reads the next email in your \p e parameter.
+ *
+ * The function returns true when the email parameter could be set. It
+ * is very important that you check that return value because otherwise
+ * you cannot actually know whether you reached the end of the list.
+ *
+ * \warning
+ * The pointers saved in the tld_email structure are taken from the
+ * list of emails defined in the tld_email_list object. If the list
+ * is changed (by a call to the parse() function) then those pointers
+ * become invalid.
+ *
+ * \param[out] e  The email object that receives the next item if there is one.
+ *
+ * \return true if e was set, false otherwise and e is not modified.
+ */
+bool tld_email_list::next(tld_email *e) const
+{
+    if(f_pos >= count())
+    {
+        return false;
+    }
+
+    build_strings();
+    email_spans_t const & spans(f_spans[f_pos]);
+    char const * str(f_strings.c_str() + spans.f_strings_offset);
+    auto next_string = [&str](span_t const & span)
+        {
+            char const * result(str);
+            str += span.f_length + 1;
+            return result;
+        };
+    e->f_group               = next_string(spans.f_group);
+    e->f_original_email      = next_string(spans.f_original_email);
+    e->f_fullname            = next_string(spans.f_fullname);
+    e->f_username            = next_string(spans.f_username);
+    e->f_domain              = next_string(spans.f_domain);
+    e->f_email_only          = next_string(spans.f_email_only);
+    e->f_canonicalized_email = next_string(spans.f_canonicalized_email);
+    ++f_pos;
+
+    return true;
+}
+
+/** \brief Retrieve the spans of the next email.
+ *
+ * This function reads the next email in your \p e parameter. Contrary
+ * to the other next() functions, this one does not copy any string.
+ * Each field is a pointer and a length. The pointer is either in the
+ * string passed to parse_views() (or the copy made by parse()) or in
+ * the arena of this list. The strings are not null terminated.
+ *
+ * \warning
+ * The pointers saved in the tld_email_view structure become invalid
+ * once the list gets parsed again or is destroyed. When the list was
+ * parsed with parse_views(), they also become invalid if the input
+ * buffer gets modified or released.
+ *
+ * \param[out] e  The email view that receives the next item if there is one.
+ *
+ * \return true if e was set, false otherwise and e is not modified.
+ *
+ * \sa parse_views()
+ */
+bool tld_email_list::next(tld_email_view *e) const
+{
+    if(f_pos >= count())
+    {
+        return false;
+    }
+
+    char const * s(source());
+    auto set_view = [this, s](tld_string_span & view, span_t const & span)
+        {
+            view.f_start = (span.f_arena ? f_arena.data() : s) + span.f_offset;
+            view.f_length = static_cast<int>(span.f_length);
+        };
+
+    email_spans_t const & spans(f_spans[f_pos]);
+    set_view(e->f_group,               spans.f_group);
+    set_view(e->f_original_email,      spans.f_original_email);
+    set_view(e->f_fullname,            spans.f_fullname);
+    set_view(e->f_username,            spans.f_username);
+    set_view(e->f_domain,              spans.f_domain);
+    set_view(e->f_email_only,          spans.f_email_only);
+    set_view(e->f_canonicalized_email, spans.f_canonicalized_email);
+    ++f_pos;
+
+    return true;
+}
+
+/** \brief Set the size of the cache of domains.
+ *
+ * Each email includes a domain which has to be converted to lowercase
+ * and then searched with the tld() function. In most lists, the same
+ * few domains are found over and over again. The cache remembers the
+ * result of those steps for up to \p size domains so a domain which
+ * was already found gets handled with one hash and one comparison.
+ *
+ * The cache is direct mapped: each domain has exactly one entry where
+ * it can be saved and a new domain replaces the domain found in that
+ * entry. A cache a few times larger than the number of frequent domains
+ * works best. Use the domain_cache_hits() and domain_cache_misses()
+ * functions to check whether the size is correct.
+ *
+ * The cache is not used by default. Setting the size to 0 releases it.
+ * Setting any size empties the cache and resets the counters. The cache
+ * survives calls to parse() and clear() since it is most useful when
+ * the same list object gets reused to parse many lists of emails.
+ *
+ * \warning
+ * The cache is not aware of calls to tld_load_tlds(). If you load new
+ * TLDs, call this function to empty the cache.
+ *
+ * \param[in] size  The maximum number of domains kept in the cache.
+ *
+ * \sa domain_cache_hits()
+ * \sa domain_cache_misses()
+ */
+void tld_email_list::set_domain_cache_size(size_t size)
+{
+    f_domain_cache = domain_cache_t();
+    f_domain_cache.f_entries.resize(size);
+}
+
+/** \brief Get the size of the cache of domains.
+ *
+ * \return The number of entries in the cache, 0 when there is no cache.
+ *
+ * \sa set_domain_cache_size()
+ */
+size_t tld_email_list::domain_cache_size() const
+{
+    return f_domain_cache.f_entries.size();
+}
+
+/** \brief Get the number of domains found in the cache.
  *
- * \param[out] e  The email object that receives the next item if there is one.
+ * \return The number of domains which did not have to be converted and
+ * searched again since the last call to set_domain_cache_size().
  *
- * \return true if e was set, false otherwise and e is not modified.
+ * \sa set_domain_cache_size()
  */
-bool tld_email_list::next(tld_email_t& e) const
+size_t tld_email_list::domain_cache_hits() const
 {
-    if(f_pos >= static_cast<int>(f_email_list.size()))
-    {
-        return false;
-    }
-
-    e = f_email_list[f_pos];
-    ++f_pos;
-
-    return true;
+    return f_domain_cache.f_hits;
 }
 
-/** \brief Retrieve a copy of the next email information.
+/** \brief Get the number of domains not found in the cache.
  *
- * This function reads the next email in your \p e parameter.
+ * \return The number of domains which had to be converted and searched
+ * since the last call to set_domain_cache_size().
  *
- * The function returns true when the email parameter could be set. It
- * is very important that you check that return value because otherwise
- * you cannot actually know whether you reached the end of the list.
+ * \sa set_domain_cache_size()
+ */
+size_t tld_email_list::domain_cache_misses() const
+{
+    return f_domain_cache.f_misses;
+}
+
+/** \brief Create a string from a span.
  *
- * \warning
- * The pointers saved in the tld_email structure are taken from the
- * list of emails defined in the tld_email_list object. If the list
- * is changed (by a call to the parse() function) then those pointers
- * become invalid.
+ * \param[in] source  The input string the span refers to.
+ * \param[in] arena  The arena the span refers to.
+ * \param[in] span  The span to convert to a string.
  *
- * \param[out] e  The email object that receives the next item if there is one.
+ * \return A copy of the characters referenced by \p span.
+ */
+std::string tld_email_list::span_string(char const * source, std::string const & arena, span_t const & span)
+{
+    return std::string((span.f_arena ? arena.data() : source) + span.f_offset, span.f_length);
+}
+
+/** \brief Create the null terminated strings of the C interface.
  *
- * \return true if e was set, false otherwise and e is not modified.
+ * The parser only saves spans. The first time the next(tld_email *)
+ * function gets called, this function copies all the spans, one after
+ * the other, with a null terminator, in one buffer. The buffer is
+ * cleared but not released by the next parse.
  */
-bool tld_email_list::next(tld_email *e) const
+void tld_email_list::build_strings() const
 {
-    if(f_pos >= static_cast<int>(f_email_list.size()))
+    if(!f_strings.empty())
     {
-        return false;
+        return;
     }
 
-    e->f_group               = f_email_list[f_pos].f_group.c_str();
-    e->f_original_email      = f_email_list[f_pos].f_original_email.c_str();
-    e->f_fullname            = f_email_list[f_pos].f_fullname.c_str();
-    e->f_username            = f_email_list[f_pos].f_username.c_str();
-    e->f_domain              = f_email_list[f_pos].f_domain.c_str();
-    e->f_email_only          = f_email_list[f_pos].f_email_only.c_str();
-    e->f_canonicalized_email = f_email_list[f_pos].f_canonicalized_email.c_str();
-    ++f_pos;
+    size_t size(0);
+    for(auto const & spans : f_spans)
+    {
+        size += spans.f_group.f_length
+              + spans.f_original_email.f_length
+              + spans.f_fullname.f_length
+              + spans.f_username.f_length
+              + spans.f_domain.f_length
+              + spans.f_email_only.f_length
+              + spans.f_canonicalized_email.f_length
+              + 7;
+    }
+    f_strings.reserve(size);
 
-    return true;
+    char const * s(source());
+    auto add_string = [this, s](span_t const & span)
+        {
+            f_strings.append((span.f_arena ? f_arena.data() : s) + span.f_offset, span.f_length);
+            f_strings += '\0';
+        };
+    for(auto const & spans : f_spans)
+    {
+        spans.f_strings_offset = f_strings.length();
+        add_string(spans.f_group);
+        add_string(spans.f_original_email);
+        add_string(spans.f_fullname);
+        add_string(spans.f_username);
+        add_string(spans.f_domain);
+        add_string(spans.f_email_only);
+        add_string(spans.f_canonicalized_email);
+    }
 }
 
 /** \brief Check whether a name represents a field with a list of emails.
@@ -970,23 +1682,64 @@ tld_email_field_type tld_email_list::email_field_type(const std::string& name)
  * another value otherwise.
  */
 tld_result tld_email_list::tld_email_t::parse(std::string const & email)
+{
+    char const * source(email.c_str());
+    std::string arena;
+    email_spans_t spans;
+    tld_result const result(parse_email(source, source, source + strlen(source), arena, spans, nullptr));
+    if(result != TLD_RESULT_SUCCESS)
+    {
+        return result;
+    }
+
+    f_original_email      = email;
+    f_fullname            = span_string(source, arena, spans.f_fullname);
+    f_username            = span_string(source, arena, spans.f_username);
+    f_domain              = span_string(source, arena, spans.f_domain);
+    f_email_only          = span_string(source, arena, spans.f_email_only);
+    f_canonicalized_email = span_string(source, arena, spans.f_canonicalized_email);
+
+    return TLD_RESULT_SUCCESS;
+}
+
+/** \brief Parse one email to a set of spans.
+ *
+ * This function parses the one email found between \p start and
+ * \p end. The results are saved as spans in \p spans. The spans
+ * are offsets in \p source, or in \p arena when the value had to
+ * be rewritten. The function does not modify the f_group span.
+ *
+ * \exception std::logic_error
+ * If a quoted string or a comment have an unexpected character in
+ * them then this exception is raised. See tld_email_t::parse() for
+ * details.
+ *
+ * \param[in] source  The string that the spans are relative to.
+ * \param[in] start  The start of the email in \p source.
+ * \param[in] end  The end of the email in \p source.
+ * \param[in,out] arena  The buffer where rewritten values get saved.
+ * \param[out] spans  The spans receiving the email parts.
+ * \param[in,out] cache  The cache of domains or nullptr.
+ *
+ * \return The result of the parsing, TLD_RESULT_SUCCESS on success,
+ * another value otherwise.
+ */
+tld_result tld_email_list::parse_email(char const * source, char const * start, char const * end, std::string & arena, email_spans_t & spans, domain_cache_t * cache)
 {
     // The following is parsing ONE email since we already removed the
     // groups, commas, semi-colons, leading and ending spaces.
     //
-    std::string value;
-    value.reserve(email.length());
-    std::string fullname;
-    std::string username;
-    std::string domain;
+    value_t value(source, arena);
+    value_t fullname(source, arena);
+    value_t username(source, arena);
+    value_t domain(source, arena);
     uint32_t count = 0;
     bool has_angle(false);
     bool found_at(false);
     bool found_dot(false);
     bool done(false);
-    char const * start(email.c_str());
     char const * s(start);
-    for(; *s != '\0'; ++s)
+    for(; s < end; ++s)
     {
         switch(*s)
         {
@@ -995,9 +1748,9 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
             {
                 return TLD_RESULT_INVALID;
             }
-            for(++s; *s != '"'; ++s)
+            for(++s; s >= end || *s != '"'; ++s)
             {
-                if(*s == '\0')
+                if(s >= end)
                 {
                     throw std::logic_error("somehow we found a \\0 in a quoted string in tld_email_t which should not happen since it was already checked validity in tld_email_t::parse()");
                 }
@@ -1005,7 +1758,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
                 {
                     // the backslash is not part of the result
                     ++s;
-                    if(*s == '\0')
+                    if(s >= end)
                     {
                         // this cannot actually happen because we are
                         // expected to capture those at the previous
@@ -1021,15 +1774,15 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
                     //
                     return TLD_RESULT_INVALID;
                 }
-                value += *s;
+                value.append(s);
             }
             // on entry of this loop, *s == '"'
             do
             {
                 ++s;
             }
-            while(*s == ' ');
-            if( *s != '<' && *s != '@' )
+            while(s < end && *s == ' ');
+            if(s >= end || (*s != '<' && *s != '@'))
             {
                 // A space afterwards is allowed, but '<' is expected
                 //
@@ -1043,12 +1796,13 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
             count = 1;
             for(++s; count > 0; ++s)
             {
+                if(s >= end)
+                {
+                    throw std::logic_error("somehow we found a \\0 in a comment in tld_email_t which should not happen since it was already checked in tld_email_t::parse()");
+                }
                 char c(*s);
                 switch(c)
                 {
-                case '\0':
-                    throw std::logic_error("somehow we found a \\0 in a comment in tld_email_t which should not happen since it was already checked in tld_email_t::parse()");
-
                 case '(':
                     ++count;
                     break;
@@ -1065,7 +1819,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
 
                 case '\\':
                     ++s;
-                    if(!is_quoted_char(*s))
+                    if(s >= end || !is_quoted_char(*s))
                     {
                         throw std::logic_error("somehow we found a non-quotable character after a backslash (\\) in tld_email_t which should not happen since it was already checked in tld_email_t::parse()");
                     }
@@ -1092,7 +1846,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
             }
             // trim spaces after the '['
             //
-            for(++s; *s != ']'; ++s)
+            for(++s; s < end && *s != ']'; ++s)
             {
                 char const c(*s);
                 if(c != ' ' && c != '\n' && c != '\r' && c != '\t')
@@ -1100,9 +1854,9 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
                     break;
                 }
             }
-            for(; *s != '[' && *s != '\\' && *s != ']' && *s != ' ' && *s != '\n' && *s != '\r' && *s != '\t'; ++s)
+            for(; s >= end || (*s != '[' && *s != '\\' && *s != ']' && *s != ' ' && *s != '\n' && *s != '\r' && *s != '\t'); ++s)
             {
-                if(*s == '\0')
+                if(s >= end)
                 {
                     throw std::logic_error("somehow we found a \\0 in a literal domain in tld_email_t which should not happen since it was already checked in tld_email_t::parse()");
                 }
@@ -1114,11 +1868,11 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
                     //
                     return TLD_RESULT_INVALID;
                 }
-                value += *s;
+                value.append(s);
             }
             // we can have spaces at the end, but those must be followed by ']'
             //
-            for(; *s != '[' && *s != '\\' && *s != ']'; ++s)
+            for(; s < end && *s != '[' && *s != '\\' && *s != ']'; ++s)
             {
                 char const c(*s);
                 if(c != ' ' && c != '\n' && c != '\r' && c != '\t')
@@ -1126,21 +1880,24 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
                     break;
                 }
             }
-            if(*s != ']' || value.empty())
+            if(s >= end || *s != ']' || value.empty())
             {
                 // domain literal cannot include a space
                 // nor can it be empty
                 //
                 return TLD_RESULT_NULL;
             }
-            if(value[0] == '.'
-            || *value.rbegin() == '.'
-            || value.find("..") != std::string::npos)
             {
-                // a domain cannot start or end with "."
-                // a domain cannot include ".."
-                //
-                return TLD_RESULT_INVALID;
+                char const * v(value.data());
+                if(v[0] == '.'
+                || value.back() == '.'
+                || std::search(v, v + value.length(), "..", ".." + 2) != v + value.length())
+                {
+                    // a domain cannot start or end with "."
+                    // a domain cannot include ".."
+                    //
+                    return TLD_RESULT_INVALID;
+                }
             }
             domain = value;
             value.clear();
@@ -1159,7 +1916,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
             // if we have an angle email address, whatever we found so far
             // is the user name; although it can be empty
             //
-            trim(value);
+            value.trim();
             if(!value.empty())
             {
                 fullname = value;
@@ -1177,7 +1934,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
             }
             if(domain.empty())
             {
-                trim(value);
+                value.trim();
                 if(value.empty())
                 {
                     // an empty domain name is not valid, apparently
@@ -1209,7 +1966,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
             }
             found_at = true;
             found_dot = false; // reset this flag
-            trim(value);
+            value.trim();
             if(value.empty())
             {
                 // no username is not a valid entry
@@ -1229,14 +1986,21 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
             //
             if( !value.empty() )
             {
-                value += ' ';
+                if(*s == ' ')
+                {
+                    value.append(s);
+                }
+                else
+                {
+                    value.append_char(' ');
+                }
             }
             // and skip all the others
             // (as far as I know this is not allowed in the RFC, only one space
             // between items; however, after a new-line / carriage return, you
             // could get many spaces and tabs and that's legal)
             //
-            for(++s; *s != '\0'; ++s)
+            for(++s; s < end; ++s)
             {
                 char const c(*s);
                 if(c != ' ' && c != '\n' && c != '\r' && c != '\t')
@@ -1249,13 +2013,13 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
 
         case '.':
             if(value.empty()                                // cannot start with a dot
-            || (!value.empty() && *value.rbegin() == '.')   // cannot include two dots one after the other
-            || s[1] == '@' || s[1] == '>')                  // cannot end with a dot
+            || (!value.empty() && value.back() == '.')      // cannot include two dots one after the other
+            || (s + 1 < end && (s[1] == '@' || s[1] == '>')))   // cannot end with a dot
             {
                 return TLD_RESULT_INVALID;
             }
             found_dot = true;
-            value += '.';
+            value.append(s);
             break;
 
         default:
@@ -1267,7 +2031,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
                 //
                 return TLD_RESULT_INVALID;
             }
-            value += *s;
+            value.append(s);
             break;
 
         }
@@ -1292,7 +2056,7 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
     }
     else
     {
-        trim(value);
+        value.trim();
         if(value.empty())
         {
             if(domain.empty())
@@ -1318,9 +2082,128 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
     // (i.e. proper characters, structure, and TLD)
     // for that step we use the lowercase version
     //
+    // the tld_domain_to_lowercase() function only changes the uppercase
+    // ASCII letters of a domain made of the following characters so in
+    // that case we can avoid the conversion
+    //
+    bool simple(true);
+    bool uppercase(false);
+    {
+        char const * d(domain.data());
+        for(size_t idx(0); idx < domain.length(); ++idx)
+        {
+            char const c(d[idx]);
+            if(c >= 'A' && c <= 'Z')
+            {
+                uppercase = true;
+            }
+            else if((c < 'a' || c > 'z')
+                 && (c < '0' || c > '9')
+                 && c != '.' && c != '-' && c != '/'
+                 && c != '_' && c != '~' && c != '!')
+            {
+                simple = false;
+                break;
+            }
+        }
+    }
     struct tld_info info;
-    std::unique_ptr<char, void(*)(char *)> lowercase_domain(tld_domain_to_lowercase(domain.c_str()), reinterpret_cast<void(*)(char *)>(&::free));
-    tld_result result(tld(lowercase_domain.get(), &info));
+    tld_result result(TLD_RESULT_SUCCESS);
+    value_t lowercase_domain(domain);
+
+    // a domain found in a previous email does not need to be converted
+    // and searched again
+    //
+    domain_cache_entry_t * entry(nullptr);
+    bool hit(false);
+    if(cache != nullptr)
+    {
+        uint32_t h(2166136261U);
+        char const * d(domain.data());
+        for(size_t idx(0); idx < domain.length(); ++idx)
+        {
+            h = (h ^ static_cast<unsigned char>(d[idx])) * 16777619U;
+        }
+        // the low bits of FNV-1a are weak, fold the high bits in
+        //
+        entry = &cache->f_entries[(h ^ (h >> 16)) % cache->f_entries.size()];
+        if(entry->f_used
+        && entry->f_domain.length() == domain.length()
+        && memcmp(entry->f_domain.data(), d, domain.length()) == 0)
+        {
+            ++cache->f_hits;
+            hit = true;
+            result = entry->f_result;
+            if(result == TLD_RESULT_SUCCESS
+            && (!simple || uppercase))
+            {
+                size_t const offset(arena.length());
+                arena.append(entry->f_lowercase);
+                lowercase_domain.set_arena_tail(offset);
+            }
+        }
+        else
+        {
+            ++cache->f_misses;
+        }
+    }
+    if(!hit)
+    {
+        if(simple)
+        {
+            if(uppercase)
+            {
+                // reserve first so domain.data() remains valid
+                //
+                arena.reserve(arena.length() + domain.length());
+                char const * d(domain.data());
+                lowercase_domain.clear();
+                for(size_t idx(0); idx < domain.length(); ++idx)
+                {
+                    char const c(d[idx]);
+                    lowercase_domain.append_char(c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+                }
+            }
+            result = tld_n(lowercase_domain.data(), lowercase_domain.length(), &info);
+        }
+        else
+        {
+            // convert a null terminated copy of the domain in the arena and
+            // then move the result over that copy
+            //
+            size_t const length(domain.length());
+            size_t const copy(arena.length());
+            size_t const output(copy + length + 1);
+            arena.reserve(output + length * 2 + 1);
+            arena.append(domain.data(), length);
+            arena += '\0';
+            arena.resize(output + length * 2 + 1);
+            int const r(tld_domain_to_lowercase_buffer(&arena[copy], &arena[output], length * 2 + 1));
+            if(r < 0)
+            {
+                // invalid UTF-8 or %XX, tld() returns TLD_RESULT_NULL in this case
+                //
+                arena.resize(copy);
+                result = TLD_RESULT_NULL;
+            }
+            else
+            {
+                memmove(&arena[copy], &arena[output], r);
+                arena.resize(copy + r);
+                lowercase_domain.set_arena_tail(copy);
+                result = tld_n(lowercase_domain.data(), lowercase_domain.length(), &info);
+            }
+        }
+        if(entry != nullptr)
+        {
+            // the entry is replaced by the new domain
+            //
+            entry->f_domain.assign(domain.data(), domain.length());
+            entry->f_lowercase.assign(lowercase_domain.data(), result == TLD_RESULT_SUCCESS ? lowercase_domain.length() : 0);
+            entry->f_result = result;
+            entry->f_used = true;
+        }
+    }
     if(result != TLD_RESULT_SUCCESS)
     {
         return result;
@@ -1332,32 +2215,90 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
         {
             return (c == ' ' || c == '\n' || c == '\r' || c == '\t');
         };
-    if( std::find_if( std::begin(username), std::end(username), has_whitespace ) != std::end(username) )
+    if( std::find_if( username.data(), username.data() + username.length(), has_whitespace ) != username.data() + username.length() )
     {
         return TLD_RESULT_INVALID;
     }
     //
-    if( std::find_if( std::begin(domain), std::end(domain), has_whitespace ) != std::end(domain) )
+    if( std::find_if( domain.data(), domain.data() + domain.length(), has_whitespace ) != domain.data() + domain.length() )
     {
         return TLD_RESULT_INVALID;
     }
 
-    f_original_email = email;
-    f_fullname       = fullname;
-    f_username       = username;
-    f_domain         = domain;
-    f_email_only     = quote_string(username, '\'') + "@" + quote_string(domain, '[');  // TODO protect characters...
+    auto to_span = [](value_t const & v)
+        {
+            span_t span;
+            span.f_offset = v.offset();
+            span.f_length = v.length();
+            span.f_arena  = v.in_arena();
+            return span;
+        };
+
+    spans.f_original_email.f_offset = start - source;
+    spans.f_original_email.f_length = end - start;
+    spans.f_original_email.f_arena  = false;
+    spans.f_fullname = to_span(fullname);
+    spans.f_username = to_span(username);
+    spans.f_domain   = to_span(domain);
+
+    // reserve enough space for the email only and canonicalized
+    // versions so the data() pointers remain valid while appending
+    //
+    arena.reserve(arena.length()
+                + fullname.length() * 2
+                + username.length() * 4
+                + domain.length()
+                + lowercase_domain.length()
+                + 16);
+
+    // when nothing needs quoting and the username and domain are only
+    // separated by the '@' in the input, the email only is a span of
+    // the input
+    //
+    if(!username.in_arena()
+    && !domain.in_arena()
+    && username.offset() + username.length() + 1 == domain.offset()
+    && source[username.offset() + username.length()] == '@'
+    && !requires_quotes(username.data(), username.length(), '\'')
+    && !requires_quotes(domain.data(), domain.length(), '['))
+    {
+        spans.f_email_only.f_offset = username.offset();
+        spans.f_email_only.f_length = username.length() + 1 + domain.length();
+        spans.f_email_only.f_arena  = false;
+    }
+    else
+    {
+        spans.f_email_only.f_offset = arena.length();
+        append_quoted(arena, username.data(), username.length(), '\'');  // TODO protect characters...
+        arena += '@';
+        append_quoted(arena, domain.data(), domain.length(), '[');
+        spans.f_email_only.f_length = arena.length() - spans.f_email_only.f_offset;
+        spans.f_email_only.f_arena  = true;
+    }
 
     // the canonicalized version uses the domain name in lowercase
     //
-    std::string canonicalized_email(quote_string(username, '\'') + "@" + quote_string(lowercase_domain.get(), '['));  // TODO protect characters...
-    if(fullname.empty())
+    if(fullname.empty() && simple && !uppercase)
     {
-        f_canonicalized_email = canonicalized_email;
+        spans.f_canonicalized_email = spans.f_email_only;
     }
     else
     {
-        f_canonicalized_email = quote_string(fullname, '"') + " <" + canonicalized_email + ">";  // TODO protect characters...
+        spans.f_canonicalized_email.f_offset = arena.length();
+        if(!fullname.empty())
+        {
+            append_quoted(arena, fullname.data(), fullname.length(), '"');  // TODO protect characters...
+            arena += " <";
+        }
+        append_quoted(arena, username.data(), username.length(), '\'');
+        arena += '@';
+        append_quoted(arena, lowercase_domain.data(), lowercase_domain.length(), '[');
+        if(!fullname.empty())
+        {
+            arena += '>';
+        }
+        spans.f_canonicalized_email.f_length = arena.length() - spans.f_canonicalized_email.f_offset;
+        spans.f_canonicalized_email.f_arena  = true;
     }
 
     return TLD_RESULT_SUCCESS;
@@ -1388,11 +2329,46 @@ tld_result tld_email_list::tld_email_t::parse(std::string const & email)
  */
 tld_result tld_email_list::tld_email_t::parse_group(std::string const & group)
 {
-    char const * s(group.c_str());
-    std::string g;
+    char const * source(group.c_str());
+    std::string arena;
+    span_t span;
+    tld_result const result(parse_group_name(source, source, source + strlen(source), arena, span));
+    if(result != TLD_RESULT_SUCCESS)
+    {
+        return result;
+    }
+
+    f_group = span_string(source, arena, span);
+
+    return TLD_RESULT_SUCCESS;
+}
+
+/** \brief Parse a group name to a span.
+ *
+ * This function parses the group name found between \p start and
+ * \p end as described in tld_email_t::parse_group(). The result is
+ * saved in \p group as a span of \p source, or of \p arena when
+ * comments or white spaces had to be removed.
+ *
+ * \exception std::logic_error
+ * This exception is raised if the function detects an invalid comment.
+ *
+ * \param[in] source  The string that the span is relative to.
+ * \param[in] start  The start of the group name in \p source.
+ * \param[in] end  The end of the group name in \p source.
+ * \param[in,out] arena  The buffer where a rewritten name gets saved.
+ * \param[out] group  The span receiving the group name.
+ *
+ * \return Whether the function succeeded (TLD_RESULT_SUCCESS) or
+ * failed (TLD_RESULT_INVALID).
+ */
+tld_result tld_email_list::parse_group_name(char const * source, char const * start, char const * end, std::string & arena, span_t & group)
+{
+    char const * s(start);
+    value_t g(source, arena);
     uint32_t count = 0;
 
-    for(; *s != '\0'; ++s)
+    for(; s < end; ++s)
     {
         switch(*s)
         {
@@ -1402,9 +2378,16 @@ tld_result tld_email_list::tld_email_t::parse_group(std::string const & group)
         case '\t':
             if(!g.empty())
             {
-                g += ' ';
+                if(*s == ' ')
+                {
+                    g.append(s);
+                }
+                else
+                {
+                    g.append_char(' ');
+                }
             }
-            for(++s; *s == ' ' || *s == '\n' || *s == '\r' || *s == '\t'; ++s);
+            for(++s; s < end && (*s == ' ' || *s == '\n' || *s == '\r' || *s == '\t'); ++s);
             --s;
             break;
 
@@ -1415,7 +2398,7 @@ tld_result tld_email_list::tld_email_t::parse_group(std::string const & group)
             for(++s; count > 0; ++s)
 #pragma GCC diagnostic pop
             {
-                if(*s == '\0')
+                if(s >= end)
                 {
                     throw std::logic_error("somehow we found a \\0 in a quoted string in tld_email_t which should not happen since it was already checked in tld_email_t::parse()");
                 }
@@ -1430,7 +2413,7 @@ tld_result tld_email_list::tld_email_t::parse_group(std::string const & group)
                     break;
 
                 case '\\':
-                    if(!is_quoted_char(s[1]))
+                    if(s + 1 >= end || !is_quoted_char(s[1]))
                     {
                         throw std::logic_error("somehow we found a non-quotable character in tld_email_t which should not happen since it was already checked in tld_email_t::parse()");
                     }
@@ -1449,7 +2432,7 @@ tld_result tld_email_list::tld_email_t::parse_group(std::string const & group)
             {
                 return TLD_RESULT_INVALID;
             }
-            g += *s;
+            g.append(s);
             break;
 
         }
@@ -1459,7 +2442,9 @@ tld_result tld_email_list::tld_email_t::parse_group(std::string const & group)
         return TLD_RESULT_INVALID;
     }
 
-    f_group = g;
+    group.f_offset = g.offset();
+    group.f_length = g.length();
+    group.f_arena  = g.in_arena();
 
     return TLD_RESULT_SUCCESS;
 }
@@ -1495,12 +2480,32 @@ void tld_email_free(struct tld_email_list * list)
     delete list;
 }
 
+/** \brief Clear a list of emails.
+ *
+ * This function removes all the emails from the list, without releasing
+ * its buffers. To parse many lists of emails, allocate one list with
+ * tld_email_alloc() and call tld_email_parse() repeatedly. Once the
+ * buffers are large enough, parsing does not allocate memory anymore.
+ *
+ * \param[in] list  The list to be cleared.
+ *
+ * \sa tld_email_parse()
+ */
+void tld_email_clear(struct tld_email_list * list)
+{
+    list->clear();
+}
+
 /** \brief Parse a list of emails in the email list object.
  *
  * This function parses the email listed in the \p emails parameter
  * and saves the result in the list parameter. The function saves
  * the information as a list of email list in the \p list object.
  *
+ * The \p list object can be reused any number of times. Its buffers
+ * are kept between calls so parsing does not allocate memory once they
+ * are large enough.
+ *
  * \param[in] list  The list of emails object.
  * \param[in] emails  The list of emails to be parsed.
  * \param[in] flags  The flags are used to change the behavior of the parser.
@@ -1561,6 +2566,87 @@ int tld_email_next(struct tld_email_list * list, struct tld_email * e)
     return list->next(e) ? 1 : 0;
 }
 
+/** \brief Parse a list of emails without copying it.
+ *
+ * This function parses the emails listed in the \p emails parameter
+ * like tld_email_parse() does, except that the string does not get
+ * copied. The results are retrieved with tld_email_next_view() and
+ * point directly in \p emails whenever possible.
+ *
+ * \warning
+ * The \p emails buffer must remain valid and unchanged until the list
+ * is freed or parsed again.
+ *
+ * \param[in] list  The list of emails object.
+ * \param[in] emails  The list of emails to be parsed.
+ * \param[in] flags  The flags are used to change the behavior of the parser.
+ *
+ * \return TLD_RESULT_SUCCESS if the email was parsed successfully,
+ *         another TLD_RESULT_... when an error is detected
+ *
+ * \sa tld_email_next_view()
+ */
+tld_result tld_email_parse_views(struct tld_email_list * list, char const * emails, int flags)
+{
+    return list->parse_views(emails, flags);
+}
+
+/** \brief Retrieve the next email as a set of spans.
+ *
+ * This function retrieves the next email found when parsing the emails
+ * passed to the tld_email_parse_views() or tld_email_parse() function.
+ * Contrary to tld_email_next(), no strings get created. The fields are
+ * pointers and lengths and they are not null terminated.
+ *
+ * \param[in] list  The list from which the email is to be read.
+ * \param[out] e  The buffer where the email spans are to be written.
+ *
+ * \return The function returns 0 if the end of the list was reached,
+ * it returns 1 if e was defined with the next email.
+ *
+ * \sa tld_email_parse_views()
+ */
+int tld_email_next_view(struct tld_email_list * list, struct tld_email_view * e)
+{
+    return list->next(e) ? 1 : 0;
+}
+
+/** \brief Set the size of the cache of domains.
+ *
+ * This function sets the number of domains kept in the cache of
+ * the \p list. The cache is not used by default. See
+ * tld_email_list::set_domain_cache_size() for details.
+ *
+ * \param[in] list  The list of emails object.
+ * \param[in] size  The maximum number of domains kept in the cache.
+ */
+void tld_email_set_domain_cache_size(struct tld_email_list * list, size_t size)
+{
+    list->set_domain_cache_size(size);
+}
+
+/** \brief Get the number of domains found in the cache.
+ *
+ * \param[in] list  The list of emails object.
+ *
+ * \return The number of hits since the cache size was last set.
+ */
+size_t tld_email_domain_cache_hits(struct tld_email_list * list)
+{
+    return list->domain_cache_hits();
+}
+
+/** \brief Get the number of domains not found in the cache.
+ *
+ * \param[in] list  The list of emails object.
+ *
+ * \return The number of misses since the cache size was last set.
+ */
+size_t tld_email_domain_cache_misses(struct tld_email_list * list)
+{
+    return list->domain_cache_misses();
+}
+
 /** \struct tld_email
  * \brief Parts of one email.
  *
@@ -1624,6 +2710,35 @@ int tld_email_next(struct tld_email_list * list, struct tld_email * e)
  * as this field is a pointer to that other field.
  */
 
+/** \struct tld_string_span
+ * \brief A string defined by a pointer and a length.
+ *
+ * The string is not null terminated. The pointer is valid until the
+ * list of emails it was taken from gets parsed again or freed.
+ */
+
+/** \var tld_string_span::f_start
+ * \brief The first character of the string.
+ */
+
+/** \var tld_string_span::f_length
+ * \brief The number of characters in the string.
+ */
+
+/** \struct tld_email_view
+ * \brief Parts of one email as spans.
+ *
+ * This is the C structure used to return the email parts without making
+ * copies of them. The fields have the same content as the fields of the
+ * tld_email structure, only they are not null terminated. See the
+ * tld_email_list::tld_email_t structure documentation for details.
+ *
+ * \warning
+ * When the list was parsed with tld_email_parse_views(), the spans
+ * point directly in the input string. That string must remain valid
+ * for as long as you use the spans.
+ */
+
 /** \enum tld_email_field_type
  * \brief Type of email as determined by the email_field_type() function.
  *
@@ -1725,22 +2840,48 @@ int tld_email_next(struct tld_email_list * list, struct tld_email * e)
  * that first error is what appears in f_result.
  */
 
-/** \var tld_email_list::f_last_group
- * \brief The last group read in the input.
+/** \var tld_email_list::f_source
+ * \brief The string being parsed.
+ *
+ * This is the pointer passed to parse_views(). The spans which are not
+ * in the arena are offsets in this string. When parse() is used, this
+ * pointer is set to nullptr and the spans are offsets in f_input.
+ *
+ * \sa source()
+ */
+
+/** \var tld_email_list::f_source_length
+ * \brief The length of the string being parsed.
+ *
+ * This is the length of f_source. It is used to copy that string when
+ * a list filled by parse_views() gets copied.
+ */
+
+/** \var tld_email_list::f_arena
+ * \brief The buffer of the values which had to be rewritten.
+ *
+ * Most of the parts of an email are found as is in the input string.
+ * The others (i.e. a display name with comments, a domain in uppercase,
+ * an email which requires quotes) are written in this buffer. It gets
+ * cleared, but not released, each time a new list is parsed.
+ */
+
+/** \var tld_email_list::f_spans
+ * \brief The list of emails as spans.
  *
- * While reading a list of emails, a group is defined as a display name
- * followed by a colon. That name is saved in this parameter as all the
- * following emails will be assigned this group. Once the semi-colon is
- * found, the f_last_group parameter is reset back to the empty string.
+ * This vector is the complete list of all the emails found while parsing
+ * the input string. Each field is a span in the input string or in the
+ * f_arena buffer. Group names are copied in each email found in that
+ * group.
  *
- * In the end, assuming no error occured, this parameter is always an
- * empty string.
+ * \sa count()
+ * \sa next()
  */
 
 /** \var tld_email_list::f_pos
  * \brief The current position reading the emails.
  *
- * This parameter is the index in the f_email_list field. It is reset
+ * This parameter is the index in the f_spans field. It is reset
  * to zero each time you call the parse() function and the rewind()
  * function. The next() function increases it by one on each call
  * until all the emails were read in which case it stops changing.
@@ -1750,20 +2891,15 @@ int tld_email_next(struct tld_email_list * list, struct tld_email * e)
  * \sa rewind()
  */
 
-/** \var tld_email_list::f_email_list
- * \brief The list of emails.
- *
- * This vector is the complete list of all the emails found while parsing
- * the input string. Note that the parse() function clears the existing
- * list each time it is called so new emails are not appended to an
- * existing list. At the same time, the f_pos field is reset to zero.
+/** \var tld_email_list::f_strings
+ * \brief The emails as null terminated strings.
  *
- * By default the list is empty so calling next() immediately returns
- * false and the count() function returns zero.
+ * The C next() function returns pointers to null terminated strings.
+ * These are copies of all the spans, created the first time that
+ * function gets called. Note that the parse() function clears this
+ * buffer each time it is called, without releasing it.
  *
- * \sa count()
- * \sa next()
- * \sa parse()
+ * \sa next(tld_email *)
  */
 
 /** \struct tld_email_list::tld_email_t
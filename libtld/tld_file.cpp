@@ -46,82 +46,133 @@
 #include    <limits.h>
 #include    <string.h>
 
+#ifndef WIN32
+#include    <fcntl.h>
+#include    <sys/mman.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+#endif
 
 
-tld_file_error tld_file_load_stream(tld_file ** file, std::istream & in)
+
+namespace
 {
-    tld_magic magic;
-    in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
-    if(!in
-    || in.gcount() != sizeof(magic))
-    {
-        return TLD_FILE_ERROR_CANNOT_READ_FILE;
-    }
 
-    if(magic.f_riff != TLD_MAGIC
-    || magic.f_type != TLD_TLDS)
-    {
-        return TLD_FILE_ERROR_UNRECOGNIZED_FILE;
-    }
-    if(magic.f_size < sizeof(tld_header) + 4
-    || magic.f_size > 1024 * 1024)
+
+/** \brief Check whether a string identifier is valid.
+ *
+ * \param[in] file  The file with the strings.
+ * \param[in] id  The string identifier (1 based).
+ *
+ * \return true if \p id represents a string within the file.
+ */
+bool tld_file_valid_string(tld_file const * file, uint32_t id)
+{
+    --id;
+    if(id >= file->f_strings_count)
     {
-        return TLD_FILE_ERROR_INVALID_FILE_SIZE;
+        return false;
     }
-    uint32_t size(magic.f_size - sizeof(uint32_t));
+    uint64_t const end(static_cast<uint64_t>(file->f_string_offsets[id].f_string_offset)
+                     + file->f_string_lengths[id].f_string_length);
+    return end <= static_cast<uint64_t>(file->f_strings_end - file->f_strings);
+}
 
-    // we already read the type so we can skip that one in the following
-    // memory buffer & read
-    //
-    *file = reinterpret_cast<tld_file *>(malloc(sizeof(tld_file) + size));
-    if(*file == nullptr)
+
+/** \brief Verify the indexes found in the descriptions.
+ *
+ * The lookups use the descriptions without checking the indexes they
+ * include (string identifiers, offsets of the next level, tags, etc.)
+ * To make that safe, we verify all of those indexes once here.
+ *
+ * \param[in] file  The file with the descriptions to verify.
+ *
+ * \return true if all the indexes are valid.
+ */
+bool tld_file_verify_descriptions(tld_file const * file)
+{
+    uint32_t const count(file->f_descriptions_count);
+    if(count >= USHRT_MAX
+    || file->f_header->f_tld_start_offset > file->f_header->f_tld_end_offset
+    || file->f_header->f_tld_end_offset > count)
     {
-        return TLD_FILE_ERROR_OUT_OF_MEMORY;
+        return false;
     }
 
-    class auto_free
+    for(uint32_t idx(0); idx < count; ++idx)
     {
-    public:
-        auto_free(tld_file ** ptr)
-            : f_ptr(ptr)
+        tld_description const * d(file->f_descriptions + idx);
+        if(!tld_file_valid_string(file, d->f_tld))
         {
+            return false;
         }
-
-        auto_free(auto_free const &) = delete;
-
-        ~auto_free()
+        if(d->f_start_offset != USHRT_MAX
+        && (d->f_start_offset > d->f_end_offset
+            || d->f_end_offset > count))
         {
-            if(f_ptr != nullptr
-            && *f_ptr != nullptr)
-            {
-                free(*f_ptr);
-                *f_ptr = nullptr;
-            }
+            return false;
         }
-
-        auto_free & operator = (auto_free const &) = delete;
-
-        void keep()
+        if(d->f_status == TLD_STATUS_EXCEPTION
+        && d->f_exception_apply_to >= count)
         {
-            f_ptr = nullptr;
+            return false;
         }
+        for(uint32_t t(0); t < d->f_tags_count; ++t)
+        {
+            uint32_t const id(d->f_tags + t * 2);
+            if(id + 1 >= file->f_tags_size
+            || !tld_file_valid_string(file, file->f_tags[id])
+            || !tld_file_valid_string(file, file->f_tags[id + 1]))
+            {
+                return false;
+            }
+        }
+    }
 
-    private:
-        tld_file ** f_ptr = nullptr;
-    };
-    auto_free safe_ptr(file);
-
-    memset(*file, 0, sizeof(tld_file));
+    return true;
+}
 
-    tld_hunk * hunk(reinterpret_cast<tld_hunk *>(*file + 1));
 
-    in.read(reinterpret_cast<char *>(hunk), size);
-    if(!in
-    || in.gcount() != size) // this doesn't fail if the file is larger...
+/** \brief Verify the magic found at the start of a TLD file.
+ *
+ * \param[in] magic  The magic read from the file.
+ *
+ * \return TLD_FILE_ERROR_NONE if the magic represents a TLD file of a
+ * supported size.
+ */
+tld_file_error tld_file_verify_magic(tld_magic const & magic)
+{
+    if(magic.f_riff != TLD_MAGIC
+    || magic.f_type != TLD_TLDS)
     {
-        return TLD_FILE_ERROR_CANNOT_READ_FILE;
+        return TLD_FILE_ERROR_UNRECOGNIZED_FILE;
+    }
+    if(magic.f_size < sizeof(tld_header) + 4
+    || magic.f_size > 1024 * 1024)
+    {
+        return TLD_FILE_ERROR_INVALID_FILE_SIZE;
     }
 
+    return TLD_FILE_ERROR_NONE;
+}
+
+
+/** \brief Parse the hunks of a TLD file.
+ *
+ * This function goes through the hunks found in \p hunk and saves
+ * pointers to their data in \p file. The data is not copied so it has
+ * to remain valid as long as \p file is in use.
+ *
+ * The function also verifies that all the required hunks were found.
+ *
+ * \param[in,out] file  The file structure to fill. It must be cleared.
+ * \param[in] hunk  The first hunk, just after the file magic.
+ * \param[in] size  The size of all the hunks in bytes.
+ *
+ * \return TLD_FILE_ERROR_NONE if the hunks are valid.
+ */
+tld_file_error tld_file_parse_hunks(tld_file * file, tld_hunk * hunk, uint32_t size)
+{
     while(size != 0)
     {
         if(sizeof(tld_hunk) > size)
@@ -143,29 +194,29 @@ tld_file_error tld_file_load_stream(tld_file ** file, std::istream & in)
             {
                 return TLD_FILE_ERROR_INVALID_STRUCTURE_SIZE;
             }
-            if((*file)->f_header != nullptr)
+            if(file->f_header != nullptr)
             {
                 return TLD_FILE_ERROR_HUNK_FOUND_TWICE;
             }
-            (*file)->f_header = reinterpret_cast<tld_header *>(hunk + 1);
-            if((*file)->f_header->f_version_major != TLD_FILE_VERSION_MAJOR
-            || (*file)->f_header->f_version_minor != TLD_FILE_VERSION_MINOR)
+            file->f_header = reinterpret_cast<tld_header *>(hunk + 1);
+            if(file->f_header->f_version_major != TLD_FILE_VERSION_MAJOR
+            || file->f_header->f_version_minor != TLD_FILE_VERSION_MINOR)
             {
                 return TLD_FILE_ERROR_UNSUPPORTED_VERSION;
             }
             break;
 
         case TLD_DESCRIPTIONS:
-            (*file)->f_descriptions_count = hunk->f_size / sizeof(tld_description);
-            if((*file)->f_descriptions_count * sizeof(tld_description) != hunk->f_size)
+            file->f_descriptions_count = hunk->f_size / sizeof(tld_description);
+            if(file->f_descriptions_count * sizeof(tld_description) != hunk->f_size)
             {
                 return TLD_FILE_ERROR_INVALID_ARRAY_SIZE;
             }
-            if((*file)->f_descriptions != nullptr)
+            if(file->f_descriptions != nullptr)
             {
                 return TLD_FILE_ERROR_HUNK_FOUND_TWICE;
             }
-            (*file)->f_descriptions = reinterpret_cast<tld_description *>(hunk + 1);
+            file->f_descriptions = reinterpret_cast<tld_description *>(hunk + 1);
             break;
 
         case TLD_TAGS:
@@ -173,56 +224,56 @@ tld_file_error tld_file_load_stream(tld_file ** file, std::istream & in)
             // by uin32_t and not by tld_tags so the number of tags cannot
             // be inferred by the hunk size
             //
-            (*file)->f_tags_size = hunk->f_size / sizeof(uint32_t);
-            if((*file)->f_tags_size * sizeof(uint32_t) != hunk->f_size)
+            file->f_tags_size = hunk->f_size / sizeof(uint32_t);
+            if(file->f_tags_size * sizeof(uint32_t) != hunk->f_size)
             {
                 return TLD_FILE_ERROR_INVALID_ARRAY_SIZE;
             }
-            if((*file)->f_tags != nullptr)
+            if(file->f_tags != nullptr)
             {
                 return TLD_FILE_ERROR_HUNK_FOUND_TWICE;
             }
-            (*file)->f_tags = reinterpret_cast<uint32_t *>(hunk + 1);
+            file->f_tags = reinterpret_cast<uint32_t *>(hunk + 1);
             break;
 
         case TLD_STRING_OFFSETS:
-            if((*file)->f_strings_count == 0)
+            if(file->f_strings_count == 0)
             {
-                (*file)->f_strings_count = hunk->f_size / sizeof(tld_string_offset);
-                if((*file)->f_strings_count == 0)
+                file->f_strings_count = hunk->f_size / sizeof(tld_string_offset);
+                if(file->f_strings_count == 0)
                 {
                     return TLD_FILE_ERROR_INVALID_ARRAY_SIZE;
                 }
             }
-            if((*file)->f_strings_count * sizeof(tld_string_offset) != hunk->f_size)
+            if(file->f_strings_count * sizeof(tld_string_offset) != hunk->f_size)
             {
                 return TLD_FILE_ERROR_INVALID_ARRAY_SIZE;
             }
-            if((*file)->f_string_offsets != nullptr)
+            if(file->f_string_offsets != nullptr)
             {
                 return TLD_FILE_ERROR_HUNK_FOUND_TWICE;
             }
-            (*file)->f_string_offsets = reinterpret_cast<tld_string_offset *>(hunk + 1);
+            file->f_string_offsets = reinterpret_cast<tld_string_offset *>(hunk + 1);
             break;
 
         case TLD_STRING_LENGTHS:
-            if((*file)->f_strings_count == 0)
+            if(file->f_strings_count == 0)
             {
-                (*file)->f_strings_count = hunk->f_size / sizeof(tld_string_length);
-                if((*file)->f_strings_count == 0)
+                file->f_strings_count = hunk->f_size / sizeof(tld_string_length);
+                if(file->f_strings_count == 0)
                 {
                     return TLD_FILE_ERROR_INVALID_ARRAY_SIZE;
                 }
             }
-            if((*file)->f_strings_count * sizeof(tld_string_length) != hunk->f_size)
+            if(file->f_strings_count * sizeof(tld_string_length) != hunk->f_size)
             {
                 return TLD_FILE_ERROR_INVALID_ARRAY_SIZE;
             }
-            if((*file)->f_string_lengths != nullptr)
+            if(file->f_string_lengths != nullptr)
             {
                 return TLD_FILE_ERROR_HUNK_FOUND_TWICE;
             }
-            (*file)->f_string_lengths = reinterpret_cast<tld_string_length *>(hunk + 1);
+            file->f_string_lengths = reinterpret_cast<tld_string_length *>(hunk + 1);
             break;
 
         case TLD_STRINGS:
@@ -230,12 +281,12 @@ tld_file_error tld_file_load_stream(tld_file ** file, std::istream & in)
             {
                 return TLD_FILE_ERROR_INVALID_ARRAY_SIZE;
             }
-            if((*file)->f_strings != nullptr)
+            if(file->f_strings != nullptr)
             {
                 return TLD_FILE_ERROR_HUNK_FOUND_TWICE;
             }
-            (*file)->f_strings = reinterpret_cast<char *>(hunk + 1);
-            (*file)->f_strings_end = reinterpret_cast<char *>(hunk + 1) + hunk->f_size;
+            file->f_strings = reinterpret_cast<char *>(hunk + 1);
+            file->f_strings_end = reinterpret_cast<char *>(hunk + 1) + hunk->f_size;
             break;
 
         default:
@@ -249,16 +300,169 @@ tld_file_error tld_file_load_stream(tld_file ** file, std::istream & in)
 
     // verify we got all the required tables
     //
-    if((*file)->f_header == nullptr
-    || (*file)->f_descriptions == nullptr
-    || (*file)->f_tags == nullptr
-    || (*file)->f_string_offsets == nullptr
-    || (*file)->f_string_lengths == nullptr
-    || (*file)->f_strings == nullptr)
+    if(file->f_header == nullptr
+    || file->f_descriptions == nullptr
+    || file->f_tags == nullptr
+    || file->f_string_offsets == nullptr
+    || file->f_string_lengths == nullptr
+    || file->f_strings == nullptr)
     {
         return TLD_FILE_ERROR_MISSING_HUNK;
     }
 
+    if(!tld_file_verify_descriptions(file))
+    {
+        return TLD_FILE_ERROR_INVALID_DESCRIPTIONS;
+    }
+
+    return TLD_FILE_ERROR_NONE;
+}
+
+
+/** \brief Use a TLD file found in memory as is.
+ *
+ * This function verifies the TLD file found in \p data and makes a
+ * tld_file point directly to it. Only the tld_file structure itself
+ * gets allocated.
+ *
+ * The structure is followed by a copy of the header since the
+ * header data is not aligned for its int64_t in the file.
+ *
+ * \param[in] data  The TLD file data, aligned for uint32_t.
+ * \param[in] size  The number of bytes available in \p data.
+ * \param[out] file  The pointer receiving the new tld_file.
+ *
+ * \return TLD_FILE_ERROR_NONE on success, another error otherwise.
+ */
+tld_file_error tld_file_attach(void const * data, std::size_t size, tld_file ** file)
+{
+    if(reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) != 0)
+    {
+        return TLD_FILE_ERROR_INVALID_ALIGNMENT;
+    }
+    if(size < sizeof(tld_magic))
+    {
+        return TLD_FILE_ERROR_CANNOT_READ_FILE;
+    }
+
+    tld_magic const * magic(reinterpret_cast<tld_magic const *>(data));
+    tld_file_error err(tld_file_verify_magic(*magic));
+    if(err != TLD_FILE_ERROR_NONE)
+    {
+        return err;
+    }
+    if(size - sizeof(uint32_t) * 2 < magic->f_size)
+    {
+        return TLD_FILE_ERROR_CANNOT_READ_FILE;
+    }
+
+    *file = reinterpret_cast<tld_file *>(malloc(sizeof(tld_file) + sizeof(tld_header)));
+    if(*file == nullptr)
+    {
+        return TLD_FILE_ERROR_OUT_OF_MEMORY;        // LCOV_EXCL_LINE
+    }
+    memset(*file, 0, sizeof(tld_file));
+
+    // the hunk data is never modified so casting away the const is safe
+    //
+    err = tld_file_parse_hunks(
+              *file
+            , reinterpret_cast<tld_hunk *>(const_cast<tld_magic *>(magic + 1))
+            , magic->f_size - sizeof(uint32_t));
+    if(err != TLD_FILE_ERROR_NONE)
+    {
+        free(*file);
+        *file = nullptr;
+        return err;
+    }
+
+    tld_header * header(reinterpret_cast<tld_header *>(*file + 1));
+    memcpy(header, (*file)->f_header, sizeof(tld_header));
+    (*file)->f_header = header;
+
+    return TLD_FILE_ERROR_NONE;
+}
+
+
+} // no name namespace
+
+
+
+tld_file_error tld_file_load_stream(tld_file ** file, std::istream & in)
+{
+    tld_magic magic;
+    in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    if(!in
+    || in.gcount() != sizeof(magic))
+    {
+        return TLD_FILE_ERROR_CANNOT_READ_FILE;
+    }
+
+    tld_file_error const magic_err(tld_file_verify_magic(magic));
+    if(magic_err != TLD_FILE_ERROR_NONE)
+    {
+        return magic_err;
+    }
+    uint32_t size(magic.f_size - sizeof(uint32_t));
+
+    // we already read the type so we can skip that one in the following
+    // memory buffer & read
+    //
+    *file = reinterpret_cast<tld_file *>(malloc(sizeof(tld_file) + size));
+    if(*file == nullptr)
+    {
+        return TLD_FILE_ERROR_OUT_OF_MEMORY;
+    }
+
+    class auto_free
+    {
+    public:
+        auto_free(tld_file ** ptr)
+            : f_ptr(ptr)
+        {
+        }
+
+        auto_free(auto_free const &) = delete;
+
+        ~auto_free()
+        {
+            if(f_ptr != nullptr
+            && *f_ptr != nullptr)
+            {
+                free(*f_ptr);
+                *f_ptr = nullptr;
+            }
+        }
+
+        auto_free & operator = (auto_free const &) = delete;
+
+        void keep()
+        {
+            f_ptr = nullptr;
+        }
+
+    private:
+        tld_file ** f_ptr = nullptr;
+    };
+    auto_free safe_ptr(file);
+
+    memset(*file, 0, sizeof(tld_file));
+
+    tld_hunk * hunk(reinterpret_cast<tld_hunk *>(*file + 1));
+
+    in.read(reinterpret_cast<char *>(hunk), size);
+    if(!in
+    || in.gcount() != size) // this doesn't fail if the file is larger...
+    {
+        return TLD_FILE_ERROR_CANNOT_READ_FILE;
+    }
+
+    tld_file_error const err(tld_file_parse_hunks(*file, hunk, size));
+    if(err != TLD_FILE_ERROR_NONE)
+    {
+        return err;
+    }
+
     // it worked, do no lose the allocated pointer
     //
     safe_ptr.keep();
@@ -295,6 +499,121 @@ enum tld_file_error tld_file_load(char const * filename, tld_file ** file)
 }
 
 
+/** \brief Use a TLD file found in memory without copying it.
+ *
+ * This function verifies the TLD file found in \p data exactly like
+ * tld_file_load() does and makes the resulting tld_file point directly
+ * in \p data. The data is never copied nor modified so it can be
+ * read-only data such as the tld_static_tlds array.
+ *
+ * The \p data buffer must be aligned for uint32_t and it must remain
+ * valid until tld_file_free() gets called.
+ *
+ * \param[in] data  The TLD file in memory.
+ * \param[in] size  The size of \p data in bytes.
+ * \param[out] file  The pointer receiving the new tld_file, it must be
+ * a null pointer on entry.
+ *
+ * \return TLD_FILE_ERROR_NONE on success, another error otherwise, in
+ * particular TLD_FILE_ERROR_INVALID_ALIGNMENT if \p data is not aligned.
+ */
+enum tld_file_error tld_file_load_buffer(void const * data, size_t size, tld_file ** file)
+{
+    if(file == nullptr
+    || data == nullptr)
+    {
+        return TLD_FILE_ERROR_INVALID_POINTER;
+    }
+    if(*file != nullptr)
+    {
+        return TLD_FILE_ERROR_POINTER_PRESENT;
+    }
+
+    return tld_file_attach(data, size, file);
+}
+
+
+/** \brief Map a TLD file in memory.
+ *
+ * This function is similar to tld_file_load() except that the file is
+ * not read in a buffer. Instead, it gets mapped read-only in memory and
+ * the pointers of the resulting tld_file point directly in that mapping.
+ * The file is verified exactly the same way.
+ *
+ * Since the mapping is shared, all the processes using the same file
+ * share one copy in the page cache and loading the file requires no
+ * read() calls.
+ *
+ * \warning
+ * The file must not be modified in place while it is mapped. To update
+ * it, write a new file and rename() it over the old one. The existing
+ * mappings then keep the old data until tld_file_free() gets called.
+ *
+ * \param[in] filename  The name of the file to map.
+ * \param[out] file  The pointer receiving the new tld_file, it must be
+ * a null pointer on entry.
+ *
+ * \return TLD_FILE_ERROR_NONE on success, another error otherwise.
+ */
+enum tld_file_error tld_file_map(char const * filename, tld_file ** file)
+{
+    if(file == nullptr
+    || filename == nullptr)
+    {
+        return TLD_FILE_ERROR_INVALID_POINTER;
+    }
+    if(*file != nullptr)
+    {
+        return TLD_FILE_ERROR_POINTER_PRESENT;
+    }
+
+#ifdef WIN32
+    return tld_file_load(filename, file);
+#else
+    int const fd(open(filename, O_RDONLY | O_CLOEXEC));
+    if(fd < 0)
+    {
+        return TLD_FILE_ERROR_CANNOT_OPEN_FILE;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        close(fd);                                  // LCOV_EXCL_LINE
+        return TLD_FILE_ERROR_CANNOT_READ_FILE;     // LCOV_EXCL_LINE
+    }
+    if(static_cast<std::size_t>(st.st_size) < sizeof(tld_magic))
+    {
+        // also avoids an mmap() of 0 bytes
+        //
+        close(fd);
+        return TLD_FILE_ERROR_CANNOT_READ_FILE;
+    }
+
+    // the mapping remains valid once the file descriptor is closed
+    //
+    std::size_t const mapping_size(st.st_size);
+    void * mapping(mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0));
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        return TLD_FILE_ERROR_CANNOT_READ_FILE;
+    }
+
+    tld_file_error const err(tld_file_attach(mapping, mapping_size, file));
+    if(err != TLD_FILE_ERROR_NONE)
+    {
+        munmap(mapping, mapping_size);
+        return err;
+    }
+    (*file)->f_mapping = mapping;
+    (*file)->f_mapping_size = mapping_size;
+
+    return TLD_FILE_ERROR_NONE;
+#endif
+}
+
+
 const char *tld_file_errstr(tld_file_error err)
 {
     switch(err)
@@ -341,6 +660,12 @@ const char *tld_file_errstr(tld_file_error err)
     case TLD_FILE_ERROR_HUNK_FOUND_TWICE:
         return "Found the same hunk twice";
 
+    case TLD_FILE_ERROR_INVALID_ALIGNMENT:
+        return "The buffer is not properly aligned";
+
+    case TLD_FILE_ERROR_INVALID_DESCRIPTIONS:
+        return "The descriptions include invalid indexes";
+
     //default: -- handled below, without a default, we know whether we missed
     //            some new TLD_FILE_ERROR_... in our cases above.
     }
@@ -492,6 +817,12 @@ void tld_file_free(tld_file ** file)
     if(file != nullptr
     && *file != nullptr)
     {
+#ifndef WIN32
+        if((*file)->f_mapping != nullptr)
+        {
+            munmap((*file)->f_mapping, (*file)->f_mapping_size);
+        }
+#endif
         free(*file);
         *file = nullptr;
     }
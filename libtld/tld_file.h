@@ -53,6 +53,7 @@
 
 // C
 //
+#include    <stddef.h>
 #include    <stdint.h>
 
 
@@ -160,6 +161,8 @@ struct tld_file
     struct tld_string_length *  f_string_lengths;
     char *                      f_strings;
     char *                      f_strings_end;
+    void *                      f_mapping;          // the file mapping when loaded with tld_file_map(), otherwise nullptr
+    size_t                      f_mapping_size;
 };
 
 
@@ -179,10 +182,14 @@ enum tld_file_error
     TLD_FILE_ERROR_UNSUPPORTED_VERSION,
     TLD_FILE_ERROR_MISSING_HUNK,
     TLD_FILE_ERROR_HUNK_FOUND_TWICE,
+    TLD_FILE_ERROR_INVALID_ALIGNMENT,
+    TLD_FILE_ERROR_INVALID_DESCRIPTIONS,
 };
 
 
 enum tld_file_error             tld_file_load(const char * filename, struct tld_file ** file);
+enum tld_file_error             tld_file_map(const char * filename, struct tld_file ** file);
+enum tld_file_error             tld_file_load_buffer(const void * data, size_t size, struct tld_file ** file);
 const char *                    tld_file_errstr(enum tld_file_error err);
 const struct tld_description *  tld_file_description(struct tld_file const * file, uint32_t id);
 const struct tld_tag *          tld_file_tag(struct tld_file const * file, uint32_t id);
@@ -191,6 +198,28 @@ char *                          tld_file_to_json(struct tld_file const * file);
 void                            tld_file_free(struct tld_file ** file);
 
 
+/* The following accessors do not check their parameters. The loaders
+ * verify all the indexes found in the descriptions and the tags once,
+ * so these can be used with those indexes in the lookup hot path.
+ */
+static inline const struct tld_description * tld_file_description_unchecked(struct tld_file const * file, uint32_t id)
+{
+    return file->f_descriptions + id;
+}
+
+static inline const struct tld_tag * tld_file_tag_unchecked(struct tld_file const * file, uint32_t id)
+{
+    return (const struct tld_tag *) (file->f_tags + id);
+}
+
+static inline const char * tld_file_string_unchecked(struct tld_file const * file, uint32_t id, uint32_t * length)
+{
+    --id;
+    *length = file->f_string_lengths[id].f_string_length;
+    return file->f_strings + file->f_string_offsets[id].f_string_offset;
+}
+
+
 #ifdef __cplusplus
 
 enum tld_file_error         tld_file_load_stream(tld_file ** file, std::istream & in);
@@ -76,6 +76,25 @@ tld_object::tld_object(std::string const & domain_name)
     set_domain(domain_name);
 }
 
+#if __cplusplus >= 201703L
+/** \brief Initialize a tld object with the specified domain.
+ *
+ * This function initializes a TLD object with the specified \p domain
+ * name. This function accepts a string view so the domain name can be
+ * a slice of a larger buffer. The view can be empty to create an empty
+ * TLD object.
+ *
+ * \note
+ * The string is expected to be UTF-8.
+ *
+ * \param[in] domain_name  The domain to parse by this object.
+ */
+tld_object::tld_object(std::string_view domain_name)
+{
+    set_domain(domain_name);
+}
+#endif
+
 /** \brief Change the domain of a tld object with the newly specified domain.
  *
  * This function initializes this TLD object with the specified \p domain
@@ -116,6 +135,26 @@ void tld_object::set_domain(std::string const & domain_name)
     // TBD -- should we clear f_domain on an invalid result?
 }
 
+#if __cplusplus >= 201703L
+/** \brief Change the domain of a tld object with the newly specified domain.
+ *
+ * This function initializes a TLD object with the specified \p domain
+ * name. This function accepts a string view which does not need to be
+ * null terminated. The characters are copied only once, in the object,
+ * and the tld_n() function is used to parse that copy.
+ *
+ * \note
+ * The string is expected to be UTF-8.
+ *
+ * \param[in] domain_name  The domain to parse by this object.
+ */
+void tld_object::set_domain(std::string_view domain_name)
+{
+    f_domain = domain_name;
+    f_result = tld_n(f_domain.data(), f_domain.length(), &f_info);
+}
+#endif
+
 /** \brief Check the result of the tld() command.
  *
  * This function returns the result that the tld() command produced
@@ -157,6 +157,10 @@ echo "--- tld_test_tld_names"
 	${BUILD_PATH}/tests/tld_test_tld_names
 )
 
+############################################################################
+echo "--- tld_test_reload"
+${BUILD_PATH}/tests/tld_test_reload
+
 ############################################################################
 echo "--- tld_test_domain_lowercase"
 ${BUILD_PATH}/tests/tld_test_domain_lowercase
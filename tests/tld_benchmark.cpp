@@ -0,0 +1,1035 @@
+/* TLD library -- benchmark the TLD lookup functions
+ * Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** \file
+ * \brief Benchmark the tld() function and related lookups.
+ *
+ * This tool is not a test. It measures the time it takes to run various
+ * lookups against a list of domain names built from the
+ * tlds-alpha-by-domain.txt and public_suffix_list.dat files. It has to
+ * be run from the tests directory so it can find those files.
+ *
+ * The tool also measures tld_check_uri() against long tracking URLs
+ * with query strings of 1Kb to 4Kb and the tld_email_list parser
+ * against lists of 20 to 200 recipients.
+ *
+ * The results are given in nanoseconds per lookup. Run the tool before
+ * and after a change to see whether the change improved the speed of
+ * the library.
+ *
+ * On Linux, the tool also gives the number of instructions per lookup
+ * when the kernel lets us read the hardware counters (see
+ * /proc/sys/kernel/perf_event_paranoid). That number is much more stable
+ * than the time on a busy computer.
+ */
+
+#include    "libtld/tld.h"
+
+// C++
+//
+#include    <algorithm>
+#include    <chrono>
+#include    <fstream>
+#include    <iostream>
+#include    <random>
+#include    <string>
+#include    <vector>
+
+
+// C
+//
+#include    <stdint.h>
+#include    <stdlib.h>
+#include    <stdio.h>
+#include    <string.h>
+
+#ifdef __linux__
+#include    <linux/perf_event.h>
+#include    <sys/ioctl.h>
+#include    <sys/syscall.h>
+#include    <unistd.h>
+#endif
+
+
+
+int g_verbose = 0;
+int g_count = 100;
+double g_instructions = -1.0;
+
+typedef std::vector<std::string> string_vector_t;
+
+/* domain names with a few sub-domains */
+string_vector_t g_short_hosts;
+
+/* domain names with a long chain of sub-domains (CDN, tracking, etc.) */
+string_vector_t g_long_hosts;
+
+/* URIs with long query strings (i.e. tracking parameters) */
+string_vector_t g_tracking_uris;
+
+/* lists of recipients as found in To: and Cc: headers */
+string_vector_t g_email_lists;
+
+/* the total number of emails found in g_email_lists */
+std::size_t g_email_count = 0;
+
+/* the emails of g_email_lists, one per line */
+std::string g_email_lines;
+
+
+/** \brief Count the instructions run by this thread.
+ *
+ * This class opens a hardware counter of the instructions run in user
+ * space. If the counter is not available, start() and stop() do nothing
+ * and stop() returns 0.
+ */
+class instruction_counter
+{
+public:
+    instruction_counter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        f_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    instruction_counter(instruction_counter const &) = delete;
+    instruction_counter & operator = (instruction_counter const &) = delete;
+
+    ~instruction_counter()
+    {
+#ifdef __linux__
+        if(f_fd >= 0)
+        {
+            close(f_fd);
+        }
+#endif
+    }
+
+    bool available() const
+    {
+        return f_fd >= 0;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if(f_fd >= 0)
+        {
+            ioctl(f_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(f_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t stop()
+    {
+        uint64_t count(0);
+#ifdef __linux__
+        if(f_fd >= 0)
+        {
+            ioctl(f_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if(read(f_fd, &count, sizeof(count)) != sizeof(count))
+            {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+
+private:
+    int     f_fd = -1;
+};
+
+
+instruction_counter g_instruction_counter;
+
+
+/** \brief Save the number of instructions per lookup.
+ *
+ * \param[in] count  The number of instructions returned by stop().
+ * \param[in] lookups  The number of lookups that were run.
+ */
+void save_instructions(uint64_t count, std::size_t lookups)
+{
+    if(g_instruction_counter.available())
+    {
+        g_instructions = static_cast<double>(count) / static_cast<double>(lookups);
+    }
+}
+
+
+char to_hex(int v)
+{
+    if(v >= 10)
+    {
+        return v - 10 + 'a';
+    }
+
+    return v + '0';
+}
+
+
+/** \brief Encode the non-ASCII characters of a domain name.
+ *
+ * The tld() function expects UTF-8 characters to be encoded with %XX.
+ *
+ * \param[in] name  The name to encode.
+ *
+ * \return The encoded name.
+ */
+std::string encode(std::string const & name)
+{
+    std::string result;
+    for(char c : name)
+    {
+        if((c & 0x80) != 0)
+        {
+            result += '%';
+            result += to_hex((c >> 4) & 15);
+            result += to_hex(c & 15);
+        }
+        else if(c >= 'A' && c <= 'Z')
+        {
+            result += c | 0x20;
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result;
+}
+
+
+/** \brief Load the list of suffixes and generate the domain names.
+ *
+ * The suffixes are read from the IANA and the Mozilla lists. The
+ * wildcard and exception marks are removed so each suffix is a name
+ * that can be found by the tld() function.
+ */
+void load_hosts()
+{
+    string_vector_t suffixes;
+
+    {
+        std::ifstream in("tlds-alpha-by-domain.txt");
+        std::string line;
+        while(std::getline(in, line))
+        {
+            if(!line.empty()
+            && line[0] != '#')
+            {
+                suffixes.push_back(encode(line));
+            }
+        }
+    }
+
+    {
+        std::ifstream in("public_suffix_list.dat");
+        std::string line;
+        while(std::getline(in, line))
+        {
+            if(line.empty()
+            || line[0] == '/'
+            || line[0] == ' ')
+            {
+                continue;
+            }
+            if(line.compare(0, 2, "*.") == 0)
+            {
+                line = "any" + line.substr(1);
+            }
+            else if(line[0] == '!')
+            {
+                line = line.substr(1);
+            }
+            suffixes.push_back(encode(line));
+        }
+    }
+
+    if(suffixes.empty())
+    {
+        fprintf(stderr, "error: could not load tlds-alpha-by-domain.txt or public_suffix_list.dat; run this tool from the tests directory.\n");
+        exit(1);
+    }
+
+    for(auto const & s : suffixes)
+    {
+        g_short_hosts.push_back("www.example." + s);
+        g_long_hosts.push_back("img-03.static.eu-west-1.edge.cdn.metrics.tracking.a1b2c3d4.prod.assets.media.example." + s);
+    }
+
+    if(g_verbose)
+    {
+        printf("loaded %zu domain names\n", suffixes.size());
+    }
+}
+
+
+/** \brief Generate URIs with long query strings.
+ *
+ * The URIs look like the links found in newsletters and ads: a short
+ * path followed by many tracking parameters for a total of 1Kb to 4Kb.
+ * A few of the values include \%XX sequences. The generator always
+ * uses the same seed so the URIs are the same on each run.
+ */
+void generate_tracking_uris()
+{
+    char const * const chars("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.~");
+    std::size_t const chars_length(strlen(chars));
+    std::mt19937 rng(1234);
+
+    for(std::size_t idx(0); idx < g_short_hosts.size(); idx += 10)
+    {
+        std::string uri("https://" + g_short_hosts[idx] + "/landing/offer.html"
+                        "?utm_source=newsletter&utm_medium=email&utm_campaign=spring");
+        std::size_t const length(1024 + rng() % 3072);
+        for(int param(0); uri.length() < length; ++param)
+        {
+            uri += "&p";
+            uri += std::to_string(param);
+            uri += '=';
+            std::size_t const value_length(16 + rng() % 112);
+            for(std::size_t v(0); v < value_length; ++v)
+            {
+                if(rng() % 40 == 0)
+                {
+                    uri += "%2F";
+                }
+                else
+                {
+                    uri += chars[rng() % chars_length];
+                }
+            }
+        }
+        uri += "#top";
+        g_tracking_uris.push_back(uri);
+    }
+}
+
+
+/** \brief Generate lists of emails.
+ *
+ * The lists look like the To: and Cc: headers of mailing list messages:
+ * 20 to 200 recipients with a mix of plain emails, full names, quoted
+ * names, comments, and groups. Like in real lists, half of the domains
+ * are one of a few common domains. The other domains are taken from the
+ * list of short hosts which are valid. The generator always uses the
+ * same seed so the lists are the same on each run.
+ *
+ * The emails of all the lists are also saved one per line for the
+ * bulk validation.
+ */
+void generate_email_lists()
+{
+    char const * const names[] =
+    {
+        "Alexis", "John", "Mary", "Henri", "Lucy", "Robert", "Zoe", "Kim",
+    };
+    std::size_t const names_length(sizeof(names) / sizeof(names[0]));
+    char const * common[] =
+    {
+        "gmail.com", "outlook.com", "yahoo.com", "m2osw.com", "Example.Co.UK",
+    };
+    std::size_t const common_length(sizeof(common) / sizeof(common[0]));
+    std::mt19937 rng(5678);
+
+    // deprecated TLDs and %XX sequences are not accepted in emails
+    //
+    string_vector_t hosts;
+    for(auto const & h : g_short_hosts)
+    {
+        tld_info info;
+        if(h.find('%') == std::string::npos
+        && tld(h.c_str(), &info) == TLD_RESULT_SUCCESS)
+        {
+            hosts.push_back(h);
+        }
+    }
+
+    for(std::size_t idx(0); idx < hosts.size(); idx += 50)
+    {
+        std::size_t const recipients(20 + rng() % 181);
+        std::string list;
+        bool in_group(false);
+        for(std::size_t r(0); r < recipients; ++r)
+        {
+            if(!list.empty())
+            {
+                list += in_group ? ", " : ",\r\n ";
+            }
+            if(!in_group && rng() % 20 == 0)
+            {
+                list += "Team ";
+                list += std::to_string(r);
+                list += ": ";
+                in_group = true;
+            }
+            std::string const name(names[rng() % names_length]);
+            std::string const host(rng() % 2 == 0
+                        ? common[rng() % common_length]
+                        : hosts[(idx + r) % hosts.size()]);
+            std::string user(name);
+            user += '.';
+            user += std::to_string(rng() % 1000);
+            switch(rng() % 4)
+            {
+            case 0:
+                list += user + "@" + host;
+                break;
+
+            case 1:
+                list += name + " Smith <" + user + "@" + host + ">";
+                break;
+
+            case 2:
+                list += "\"" + name + ", Jr.\" <" + user + "@" + host + ">";
+                break;
+
+            case 3:
+                list += user + "@" + host + " (" + name + " at work)";
+                break;
+
+            }
+            if(in_group && rng() % 5 == 0)
+            {
+                list += ";";
+                in_group = false;
+            }
+        }
+        if(in_group)
+        {
+            list += ";";
+        }
+
+        tld_email_list emails;
+        if(emails.parse(list, 0) != TLD_RESULT_SUCCESS)
+        {
+            fprintf(stderr, "error: generated list of emails is not valid: \"%s\".\n", list.c_str());
+            exit(1);
+        }
+        g_email_count += emails.count();
+        g_email_lists.push_back(list);
+
+        tld_email_list::tld_email_t e;
+        while(emails.next(e))
+        {
+            if(!e.f_original_email.empty())
+            {
+                g_email_lines += e.f_original_email;
+                g_email_lines += '\n';
+            }
+        }
+    }
+}
+
+
+/** \brief Run tld() against a list of domain names.
+ *
+ * \param[in] hosts  The list of domain names to check.
+ *
+ * \return The number of nanoseconds per lookup.
+ */
+double run_tld(string_vector_t const & hosts)
+{
+    int valid(0);
+    auto const start(std::chrono::steady_clock::now());
+    g_instruction_counter.start();
+    for(int count(0); count < g_count; ++count)
+    {
+        for(auto const & h : hosts)
+        {
+            tld_info info;
+            if(tld(h.c_str(), &info) == TLD_RESULT_SUCCESS)
+            {
+                ++valid;
+            }
+        }
+    }
+    save_instructions(g_instruction_counter.stop(), hosts.size() * g_count);
+    auto const end(std::chrono::steady_clock::now());
+
+    if(g_verbose)
+    {
+        printf("%d valid domain names\n", valid);
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count()
+                / (static_cast<double>(hosts.size()) * g_count);
+}
+
+
+/** \brief Run tld_lite() against a list of domain names.
+ *
+ * \param[in] hosts  The list of domain names to check.
+ * \param[in] fields  The TLD_INFO_... fields to retrieve.
+ *
+ * \return The number of nanoseconds per lookup.
+ */
+double run_lite(string_vector_t const & hosts, int fields)
+{
+    int valid(0);
+    auto const start(std::chrono::steady_clock::now());
+    g_instruction_counter.start();
+    for(int count(0); count < g_count; ++count)
+    {
+        for(auto const & h : hosts)
+        {
+            tld_info_lite info;
+            if(tld_lite(h.c_str(), h.length(), &info, fields) == TLD_RESULT_SUCCESS)
+            {
+                ++valid;
+            }
+        }
+    }
+    save_instructions(g_instruction_counter.stop(), hosts.size() * g_count);
+    auto const end(std::chrono::steady_clock::now());
+
+    if(g_verbose)
+    {
+        printf("%d valid domain names\n", valid);
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count()
+                / (static_cast<double>(hosts.size()) * g_count);
+}
+
+
+/** \brief Run tld_suffix_offset() against a list of domain names.
+ *
+ * \param[in] hosts  The list of domain names to check.
+ *
+ * \return The number of nanoseconds per lookup.
+ */
+double run_suffix_offset(string_vector_t const & hosts)
+{
+    int valid(0);
+    auto const start(std::chrono::steady_clock::now());
+    g_instruction_counter.start();
+    for(int count(0); count < g_count; ++count)
+    {
+        for(auto const & h : hosts)
+        {
+            if(tld_suffix_offset(h.c_str(), h.length()) >= 0)
+            {
+                ++valid;
+            }
+        }
+    }
+    save_instructions(g_instruction_counter.stop(), hosts.size() * g_count);
+    auto const end(std::chrono::steady_clock::now());
+
+    if(g_verbose)
+    {
+        printf("%d valid domain names\n", valid);
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count()
+                / (static_cast<double>(hosts.size()) * g_count);
+}
+
+
+/** \brief Run tld_wire() against a list of domain names.
+ *
+ * The domain names are first converted to the DNS wire format.
+ *
+ * \param[in] hosts  The list of domain names to check.
+ *
+ * \return The number of nanoseconds per lookup.
+ */
+double run_wire(string_vector_t const & hosts)
+{
+    string_vector_t names;
+    for(auto const & h : hosts)
+    {
+        std::string wire;
+        std::string::size_type start(0);
+        for(;;)
+        {
+            std::string::size_type end(h.find('.', start));
+            if(end == std::string::npos)
+            {
+                end = h.length();
+            }
+            wire += static_cast<char>(end - start);
+            wire += h.substr(start, end - start);
+            if(end == h.length())
+            {
+                break;
+            }
+            start = end + 1;
+        }
+        wire += '\0';
+        names.push_back(wire);
+    }
+
+    int valid(0);
+    auto const start(std::chrono::steady_clock::now());
+    g_instruction_counter.start();
+    for(int count(0); count < g_count; ++count)
+    {
+        for(auto const & n : names)
+        {
+            tld_info info;
+            if(tld_wire(reinterpret_cast<uint8_t const *>(n.data()), n.length(), &info, nullptr) == TLD_RESULT_SUCCESS)
+            {
+                ++valid;
+            }
+        }
+    }
+    save_instructions(g_instruction_counter.stop(), names.size() * g_count);
+    auto const end(std::chrono::steady_clock::now());
+
+    if(g_verbose)
+    {
+        printf("%d valid domain names\n", valid);
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count()
+                / (static_cast<double>(names.size()) * g_count);
+}
+
+
+/** \brief Run tld_check_uri() against a list of URIs.
+ *
+ * \param[in] uris  The list of URIs to check.
+ * \param[in] flags  The flags passed to tld_check_uri().
+ *
+ * \return The number of nanoseconds per lookup.
+ */
+double run_check_uri(string_vector_t const & uris, int flags)
+{
+    int valid(0);
+    auto const start(std::chrono::steady_clock::now());
+    g_instruction_counter.start();
+    for(int count(0); count < g_count; ++count)
+    {
+        for(auto const & u : uris)
+        {
+            tld_info info;
+            if(tld_check_uri(u.c_str(), &info, "http,https", flags) == TLD_RESULT_SUCCESS)
+            {
+                ++valid;
+            }
+        }
+    }
+    save_instructions(g_instruction_counter.stop(), uris.size() * g_count);
+    auto const end(std::chrono::steady_clock::now());
+
+    if(g_verbose)
+    {
+        printf("%d valid URIs\n", valid);
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count()
+                / (static_cast<double>(uris.size()) * g_count);
+}
+
+
+/** \brief Parse the lists of emails.
+ *
+ * The \p mode parameter selects the interface used to parse the lists:
+ *
+ * \li 0 -- a new tld_email_list object is created for each list, the
+ * way most code used it so far;
+ * \li 1 -- one tld_email_list object is reused and the emails are read
+ * with next() in a reused tld_email_t object;
+ * \li 2 -- one tld_email_list object is reused and the emails are read
+ * with next() as views;
+ * \li 3 -- the C API with one tld_email_alloc() object reused;
+ * \li 4 -- like 1 with a cache of domains.
+ *
+ * \param[in] mode  The interface to use.
+ *
+ * \return The number of nanoseconds per email.
+ */
+double run_emails(int mode)
+{
+    std::size_t valid(0);
+    tld_email_list list;
+    tld_email_list::tld_email_t e;
+    tld_email_view view;
+    struct tld_email_list * clist(tld_email_alloc());
+    struct tld_email ce;
+    if(mode == 4)
+    {
+        list.set_domain_cache_size(256);
+    }
+    auto const start(std::chrono::steady_clock::now());
+    g_instruction_counter.start();
+    for(int count(0); count < g_count; ++count)
+    {
+        for(auto const & l : g_email_lists)
+        {
+            switch(mode)
+            {
+            case 0:
+                {
+                    tld_email_list emails;
+                    if(emails.parse(l, 0) == TLD_RESULT_SUCCESS)
+                    {
+                        while(emails.next(e))
+                        {
+                            ++valid;
+                        }
+                    }
+                }
+                break;
+
+            case 1:
+            case 4:
+                if(list.parse(l, 0) == TLD_RESULT_SUCCESS)
+                {
+                    while(list.next(e))
+                    {
+                        ++valid;
+                    }
+                }
+                break;
+
+            case 2:
+                if(list.parse_views(l.c_str(), 0) == TLD_RESULT_SUCCESS)
+                {
+                    while(list.next(&view))
+                    {
+                        ++valid;
+                    }
+                }
+                break;
+
+            case 3:
+                if(tld_email_parse(clist, l.c_str(), 0) == TLD_RESULT_SUCCESS)
+                {
+                    while(tld_email_next(clist, &ce) == 1)
+                    {
+                        ++valid;
+                    }
+                }
+                break;
+
+            }
+        }
+    }
+    save_instructions(g_instruction_counter.stop(), g_email_count * g_count);
+    auto const end(std::chrono::steady_clock::now());
+    tld_email_free(clist);
+
+    if(g_verbose)
+    {
+        printf("%d valid emails\n", static_cast<int>(valid));
+        if(mode == 4)
+        {
+            printf("%d cache hits, %d cache misses\n",
+                    static_cast<int>(list.domain_cache_hits()),
+                    static_cast<int>(list.domain_cache_misses()));
+        }
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count()
+                / (static_cast<double>(g_email_count) * g_count);
+}
+
+
+/** \brief Validate the emails with tld_email_bulk.
+ *
+ * \param[in] threads  The number of threads, 0 for one per processor.
+ *
+ * \return The number of nanoseconds per email.
+ */
+double run_email_bulk(int threads)
+{
+    tld_email_bulk bulk;
+    bulk.set_thread_count(threads);
+    std::size_t valid(0);
+    auto const start(std::chrono::steady_clock::now());
+    g_instruction_counter.start();
+    for(int count(0); count < g_count; ++count)
+    {
+        if(bulk.validate(g_email_lines.data(), g_email_lines.length(), 0) == TLD_RESULT_SUCCESS)
+        {
+            valid += bulk.count();
+        }
+    }
+    save_instructions(g_instruction_counter.stop(), bulk.count() * g_count);
+    auto const end(std::chrono::steady_clock::now());
+
+    if(g_verbose)
+    {
+        printf("%d valid emails with %d threads\n", static_cast<int>(valid), bulk.thread_count());
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count()
+                / (static_cast<double>(bulk.count()) * g_count);
+}
+
+
+double bench_tld_short()
+{
+    return run_tld(g_short_hosts);
+}
+
+
+double bench_tld_long()
+{
+    return run_tld(g_long_hosts);
+}
+
+
+double bench_lite_short()
+{
+    return run_lite(g_short_hosts, 0);
+}
+
+
+double bench_lite_short_all()
+{
+    return run_lite(g_short_hosts, TLD_INFO_ALL);
+}
+
+
+double bench_suffix_short()
+{
+    return run_suffix_offset(g_short_hosts);
+}
+
+
+double bench_suffix_long()
+{
+    return run_suffix_offset(g_long_hosts);
+}
+
+
+double bench_wire_short()
+{
+    return run_wire(g_short_hosts);
+}
+
+
+double bench_wire_long()
+{
+    return run_wire(g_long_hosts);
+}
+
+
+
+
+double bench_uri_tracking()
+{
+    return run_check_uri(g_tracking_uris, 0);
+}
+
+
+double bench_uri_tracking_strict()
+{
+    return run_check_uri(g_tracking_uris, VALID_URI_ASCII_ONLY | VALID_URI_NO_SPACES);
+}
+
+
+double bench_emails_new()
+{
+    return run_emails(0);
+}
+
+
+double bench_emails_reuse()
+{
+    return run_emails(1);
+}
+
+
+double bench_emails_views()
+{
+    return run_emails(2);
+}
+
+
+double bench_emails_c()
+{
+    return run_emails(3);
+}
+
+
+double bench_emails_cache()
+{
+    return run_emails(4);
+}
+
+
+double bench_emails_bulk_1()
+{
+    return run_email_bulk(1);
+}
+
+
+double bench_emails_bulk()
+{
+    return run_email_bulk(0);
+}
+
+
+struct benchmark_t
+{
+    char const *    f_name;
+    char const *    f_description;
+    double          (*f_run)();
+};
+
+benchmark_t const g_benchmarks[] =
+{
+    { "tld-short", "tld() with www.example.<suffix>",            bench_tld_short },
+    { "tld-long",  "tld() with 12 sub-domains before <suffix>",  bench_tld_long  },
+    { "lite-short", "tld_lite() with www.example.<suffix>, no optional fields", bench_lite_short },
+    { "lite-short-all", "tld_lite() with www.example.<suffix>, TLD_INFO_ALL", bench_lite_short_all },
+    { "suffix-short", "tld_suffix_offset() with www.example.<suffix>", bench_suffix_short },
+    { "suffix-long", "tld_suffix_offset() with 12 sub-domains before <suffix>", bench_suffix_long },
+    { "wire-short", "tld_wire() with www.example.<suffix>",      bench_wire_short },
+    { "wire-long", "tld_wire() with 12 sub-domains before <suffix>", bench_wire_long },
+    { "uri-tracking", "tld_check_uri() with 1Kb to 4Kb query strings", bench_uri_tracking },
+    { "uri-tracking-strict", "same with VALID_URI_ASCII_ONLY | VALID_URI_NO_SPACES", bench_uri_tracking_strict },
+    { "emails-new", "tld_email_list::parse() with a new list each time", bench_emails_new },
+    { "emails-reuse", "tld_email_list::parse() and next() reusing the objects", bench_emails_reuse },
+    { "emails-views", "tld_email_list::parse_views() reusing the list", bench_emails_views },
+    { "emails-c", "tld_email_parse() reusing the tld_email_alloc() list", bench_emails_c },
+    { "emails-cache", "tld_email_list::parse() reusing the list with a cache of domains", bench_emails_cache },
+    { "emails-bulk-1", "tld_email_bulk::validate() with one email per line, one thread", bench_emails_bulk_1 },
+    { "emails-bulk", "tld_email_bulk::validate() with one email per line, one thread per processor", bench_emails_bulk },
+};
+
+
+void run(benchmark_t const & b)
+{
+    g_instructions = -1.0;
+    double const ns(b.f_run());
+    if(g_instructions >= 0.0)
+    {
+        printf("%-20s %10.2f ns/lookup %10.1f instructions/lookup -- %s\n", b.f_name, ns, g_instructions, b.f_description);
+    }
+    else
+    {
+        printf("%-20s %10.2f ns/lookup -- %s\n", b.f_name, ns, b.f_description);
+    }
+}
+
+
+void usage()
+{
+    printf("Usage: tld_benchmark [-v] [-c <count>] [<name> ...]\n");
+    printf("Where <name> is one of:\n");
+    for(auto const & b : g_benchmarks)
+    {
+        printf("  %-20s %s\n", b.f_name, b.f_description);
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    printf("benchmarking tld version %s\n", tld_version());
+
+    string_vector_t names;
+    for(int i(1); i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-v") == 0)
+        {
+            g_verbose = 1;
+        }
+        else if(strcmp(argv[i], "-c") == 0
+             && i + 1 < argc)
+        {
+            ++i;
+            g_count = atoi(argv[i]);
+            if(g_count <= 0)
+            {
+                fprintf(stderr, "error: the count must be a positive number.\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-h") == 0
+             || strcmp(argv[i], "--help") == 0)
+        {
+            usage();
+            exit(0);
+        }
+        else
+        {
+            names.push_back(argv[i]);
+        }
+    }
+
+    load_hosts();
+    generate_tracking_uris();
+    generate_email_lists();
+
+    if(!g_instruction_counter.available())
+    {
+        printf("note: the instruction counter is not available, only the time gets measured.\n");
+    }
+
+    // make sure the TLDs are loaded before we start measuring
+    //
+    tld_load_tlds(nullptr, 1);
+
+    if(names.empty())
+    {
+        for(auto const & b : g_benchmarks)
+        {
+            run(b);
+        }
+    }
+    else
+    {
+        for(auto const & n : names)
+        {
+            bool found(false);
+            for(auto const & b : g_benchmarks)
+            {
+                if(n == b.f_name)
+                {
+                    run(b);
+                    found = true;
+                    break;
+                }
+            }
+            if(!found)
+            {
+                fprintf(stderr, "error: unknown benchmark \"%s\".\n", n.c_str());
+                exit(1);
+            }
+        }
+    }
+
+    exit(0);
+}
+
+/* vim: ts=4 sw=4 et
+ */
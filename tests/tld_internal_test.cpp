@@ -45,6 +45,14 @@ extern "C" {
 }
 
 
+// C++
+//
+#include    <atomic>
+#include    <chrono>
+#include    <string>
+#include    <thread>
+
+
 // C
 //
 #include    <stdlib.h>
@@ -228,10 +236,19 @@ void test_search()
 
     size_t i;
 
+    // the search() function expects the TLDs to be loaded
+    //
+    if(tld_load_tlds(nullptr, 1) != TLD_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "error: test_search() could not load the TLDs\n");
+        ++err_count;
+        return;
+    }
+
     size_t const max = sizeof(d) / sizeof(d[0]);
     for(i = 0; i < max; ++i)
     {
-        int const r = search(d[i].f_start, d[i].f_end, d[i].f_tld, d[i].f_length);
+        int const r = search(&g_tld_context, d[i].f_start, d[i].f_end, d[i].f_tld, d[i].f_length);
         if(r != d[i].f_result)
         {
             fprintf(stderr, "error: test_search() failed with \"%s\", expected %d and got %d [3]\n",
@@ -252,13 +269,13 @@ void test_search_array(int start, int end)
     /* now test all from the arrays */
     for(i = start; i < end; ++i)
     {
-        tld = tld_file_description(g_tld_file, i);
-        name = tld_file_string(g_tld_file, tld->f_tld, &l);
+        tld = tld_file_description(g_tld_context.f_file, i);
+        name = tld_file_string(g_tld_context.f_file, tld->f_tld, &l);
         if(verbose)
         {
             printf("{%d..%d} i = %d, [%.*s]\n", start, end, i, l, name);
         }
-        r = search(start, end, name, l);
+        r = search(&g_tld_context, start, end, name, l);
         if(r != i)
         {
             fprintf(stderr, "error: test_search_array() failed with \"%.*s\", expected %d and got %d [4]\n",
@@ -275,8 +292,172 @@ void test_search_array(int start, int end)
 void test_search_all()
 {
     test_search_array(
-              g_tld_file->f_header->f_tld_start_offset
-            , g_tld_file->f_header->f_tld_end_offset);
+              g_tld_context.f_file->f_header->f_tld_start_offset
+            , g_tld_context.f_file->f_header->f_tld_end_offset);
+}
+
+
+void test_hash_search_array(int start, int end)
+{
+    const struct tld_description *  tld(nullptr);
+    int                             i(0), r(0), e(0);
+    uint32_t                        l(0);
+    const char *                    name(nullptr);
+    std::string                     miss;
+
+    for(i = start; i < end; ++i)
+    {
+        tld = tld_file_description(g_tld_context.f_file, i);
+        name = tld_file_string(g_tld_context.f_file, tld->f_tld, &l);
+        r = hash_search(&g_tld_context, start, end, name, l);
+        if(r != i)
+        {
+            fprintf(stderr, "error: test_hash_search_array() failed with \"%.*s\", expected %d and got %d [5]\n",
+                    l, name, i, r);
+            ++err_count;
+        }
+
+        // names which are not expected to be found, the result must
+        // still be the same as search() (i.e. when there is a "*")
+        //
+        miss = std::string(name, l) + "z";
+        r = hash_search(&g_tld_context, start, end, miss.c_str(), miss.length());
+        e = search(&g_tld_context, start, end, miss.c_str(), miss.length());
+        if(r != e)
+        {
+            fprintf(stderr, "error: test_hash_search_array() failed with \"%s\", expected %d and got %d [6]\n",
+                    miss.c_str(), e, r);
+            ++err_count;
+        }
+        r = hash_search(&g_tld_context, start, end, name, l - 1);
+        e = search(&g_tld_context, start, end, name, l - 1);
+        if(r != e)
+        {
+            fprintf(stderr, "error: test_hash_search_array() failed with \"%.*s\", expected %d and got %d [7]\n",
+                    l - 1, name, e, r);
+            ++err_count;
+        }
+
+        if(tld->f_start_offset != USHRT_MAX)
+        {
+            test_hash_search_array(tld->f_start_offset, tld->f_end_offset);
+        }
+    }
+}
+
+void test_hash_search_all()
+{
+    if(g_tld_context.f_hash_index.f_slots == nullptr)
+    {
+        fprintf(stderr, "error: the hash index was not built when loading the TLDs.\n");
+        ++err_count;
+        return;
+    }
+
+    test_hash_search_array(
+              g_tld_context.f_file->f_header->f_tld_start_offset
+            , g_tld_context.f_file->f_header->f_tld_end_offset);
+}
+
+
+void test_description_infos()
+{
+    if(g_tld_context.f_description_infos == nullptr)
+    {
+        fprintf(stderr, "error: the description infos were not built when loading the TLDs.\n");
+        ++err_count;
+        return;
+    }
+
+    // the same context without the precomputed infos searches the tags
+    //
+    tld_context tags_context(g_tld_context);
+    tags_context.f_description_infos = nullptr;
+
+    int countries(0);
+    uint32_t const count(g_tld_context.f_file->f_descriptions_count);
+    for(uint32_t idx(0); idx < count; ++idx)
+    {
+        tld_description const * tld(tld_file_description(g_tld_context.f_file, idx));
+
+        tld_info info;
+        tld_clear_info(&info);
+        tags_to_info(&g_tld_context, tld, &info);
+
+        tld_info expected;
+        tld_clear_info(&expected);
+        tags_to_info(&tags_context, tld, &expected);
+
+        if(info.f_category != expected.f_category
+        || strcmp(info.f_country, expected.f_country) != 0)
+        {
+            fprintf(stderr, "error: test_description_infos() failed with description %u, expected %d/\"%s\" and got %d/\"%s\".\n",
+                    idx, expected.f_category, expected.f_country, info.f_category, info.f_country);
+            ++err_count;
+        }
+        if(info.f_country[0] != '\0')
+        {
+            ++countries;
+        }
+    }
+
+    if(countries == 0)
+    {
+        fprintf(stderr, "error: test_description_infos() did not find any country.\n");
+        ++err_count;
+    }
+}
+
+
+void test_reclaim_contexts()
+{
+    struct tld_info info;
+
+    if(tld("www.m2osw.com", &info) != TLD_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "error: tld() failed before the reload.\n");
+        ++err_count;
+    }
+
+    // a lookup still running on the context which gets retired
+    //
+    std::atomic<bool> searching(false);
+    std::atomic<bool> done(false);
+    std::thread reader([&searching, &done]()
+        {
+            default_context const context;
+            searching = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            done = true;
+        });
+    while(!searching)
+    {
+        std::this_thread::yield();
+    }
+
+    if(tld_reload_tlds(nullptr, 1) != TLD_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "error: tld_reload_tlds() failed.\n");
+        ++err_count;
+    }
+
+    // the reload waited for that lookup and released the previous context
+    //
+    if(!done
+    || !g_tld_retired.empty())
+    {
+        fprintf(stderr, "error: tld_reload_tlds() did not wait for the lookup using the previous context.\n");
+        ++err_count;
+    }
+    reader.join();
+
+    if(tld("www.m2osw.com", &info) != TLD_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "error: tld() failed after the reload.\n");
+        ++err_count;
+    }
+
+    tld_free_tlds();
 }
 
 
@@ -303,6 +484,9 @@ int main(int argc, char *argv[])
     test_compare();
     test_search();
     test_search_all();
+    test_hash_search_all();
+    test_description_infos();
+    test_reclaim_contexts();
 
     if(err_count)
     {
@@ -303,7 +303,771 @@ void test_specific()
 
 
 /*
- * This test goes through all the domain names and extracts the domain,
+ * This tests the tld_n() function with the same ad hoc domains placed
+ * in a larger buffer which is not null terminated where the domain ends.
+ */
+void test_slices()
+{
+    char buffer[1024];
+    struct tld_info info, info_n;
+    enum tld_result r, r_n;
+
+    for(size_t idx = 0; idx < sizeof(g_uris) / sizeof(g_uris[0]); ++idx)
+    {
+        size_t const length = strlen(g_uris[idx].f_uri);
+        if(length + 8 > sizeof(buffer))
+        {
+            continue;
+        }
+        memcpy(buffer, "Host: ", 6);
+        memcpy(buffer + 6, g_uris[idx].f_uri, length);
+        memcpy(buffer + 6 + length, ".x", 2);
+
+        r = tld(g_uris[idx].f_uri, &info);
+        r_n = tld_n(buffer + 6, length, &info_n);
+        if(r != r_n)
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_n() got result %d, expected %d\n",
+                        g_uris[idx].f_uri, r_n, r);
+            ++err_count;
+        }
+        else if(info.f_offset != info_n.f_offset
+             || info.f_status != info_n.f_status
+             || info.f_category != info_n.f_category
+             || info.f_tld_index != info_n.f_tld_index
+             || strcmp(info.f_country, info_n.f_country) != 0)
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_n() did not return the same info as tld()\n",
+                        g_uris[idx].f_uri);
+            ++err_count;
+        }
+        else if(info.f_tld != NULL
+             && info_n.f_tld != buffer + 6 + (info.f_tld - g_uris[idx].f_uri))
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_n() did not return a pointer in the input buffer\n",
+                        g_uris[idx].f_uri);
+            ++err_count;
+        }
+    }
+
+    r = tld_n(NULL, 10, &info);
+    if(r != TLD_RESULT_NULL)
+    {
+        fprintf(stderr, "error: tld_n() with a NULL pointer returned %d instead of TLD_RESULT_NULL\n", r);
+        ++err_count;
+    }
+
+    r = tld_n("example.com", 0, &info);
+    if(r != TLD_RESULT_NULL)
+    {
+        fprintf(stderr, "error: tld_n() with a zero length returned %d instead of TLD_RESULT_NULL\n", r);
+        ++err_count;
+    }
+}
+
+
+/*
+ * This tests the tld_lite() function with the same ad hoc domains and
+ * verifies that only the requested fields get set. It also verifies
+ * that tld_suffix_offset() returns the same offset as tld().
+ */
+void test_lite()
+{
+    struct tld_info info;
+    struct tld_info_lite lite;
+    enum tld_result r, r_lite;
+    size_t length;
+    int fields, offset;
+
+    for(size_t idx = 0; idx < sizeof(g_uris) / sizeof(g_uris[0]); ++idx)
+    {
+        length = strlen(g_uris[idx].f_uri);
+        r = tld(g_uris[idx].f_uri, &info);
+        offset = tld_suffix_offset(g_uris[idx].f_uri, length);
+        if(offset != (r == TLD_RESULT_SUCCESS ? info.f_offset : -1))
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_suffix_offset() got %d, expected %d\n",
+                        g_uris[idx].f_uri, offset, r == TLD_RESULT_SUCCESS ? info.f_offset : -1);
+            ++err_count;
+        }
+        for(fields = 0; fields <= TLD_INFO_ALL; ++fields)
+        {
+            r_lite = tld_lite(g_uris[idx].f_uri, length, &lite, fields);
+            if(r != r_lite)
+            {
+                fprintf(stderr, "error: testing URI \"%s\" with tld_lite(%d) got result %d, expected %d\n",
+                            g_uris[idx].f_uri, fields, r_lite, r);
+                ++err_count;
+            }
+            else if(info.f_offset != lite.f_offset
+                 || info.f_status != lite.f_status
+                 || info.f_tld != lite.f_tld
+                 || info.f_tld_index != lite.f_tld_index)
+            {
+                fprintf(stderr, "error: testing URI \"%s\" with tld_lite(%d) did not return the same info as tld()\n",
+                            g_uris[idx].f_uri, fields);
+                ++err_count;
+            }
+            else if((fields & TLD_INFO_CATEGORY) != 0
+                    ? lite.f_category != info.f_category
+                    : lite.f_category != TLD_CATEGORY_UNDEFINED)
+            {
+                fprintf(stderr, "error: testing URI \"%s\" with tld_lite(%d) returned the wrong category\n",
+                            g_uris[idx].f_uri, fields);
+                ++err_count;
+            }
+            else if((fields & TLD_INFO_COUNTRY) != 0 && info.f_country[0] != '\0'
+                    ? lite.f_country == NULL
+                        || lite.f_country_length != (int) strlen(info.f_country)
+                        || memcmp(lite.f_country, info.f_country, lite.f_country_length) != 0
+                    : lite.f_country != NULL || lite.f_country_length != 0)
+            {
+                fprintf(stderr, "error: testing URI \"%s\" with tld_lite(%d) returned the wrong country\n",
+                            g_uris[idx].f_uri, fields);
+                ++err_count;
+            }
+        }
+    }
+
+    r = tld_lite(NULL, 10, &lite, TLD_INFO_ALL);
+    if(r != TLD_RESULT_NULL
+    || lite.f_tld_index != -1
+    || lite.f_country != NULL)
+    {
+        fprintf(stderr, "error: tld_lite() with a NULL pointer returned %d instead of TLD_RESULT_NULL\n", r);
+        ++err_count;
+    }
+
+    if(tld_suffix_offset(NULL, 10) != -1
+    || tld_suffix_offset("no-period", 9) != -1)
+    {
+        fprintf(stderr, "error: tld_suffix_offset() did not return -1 on invalid input\n");
+        ++err_count;
+    }
+
+    r = tld_lite("double..period.com", 18, &lite, TLD_INFO_ALL);
+    if(r != TLD_RESULT_BAD_URI)
+    {
+        fprintf(stderr, "error: tld_lite() with two periods returned %d instead of TLD_RESULT_BAD_URI\n", r);
+        ++err_count;
+    }
+}
+
+
+/*
+ * This tests the tld_split_domain() function with a few domain names
+ * and verifies the parts against what tld() returns for g_uris.
+ */
+void check_span(const char *host, const char *name, const struct tld_span *span, const char *expected)
+{
+    if(expected == NULL)
+    {
+        if(span->f_offset != -1 || span->f_length != 0)
+        {
+            fprintf(stderr, "error: tld_split_domain(\"%s\") %s is %d/%d, expected absent\n",
+                        host, name, span->f_offset, span->f_length);
+            ++err_count;
+        }
+    }
+    else if(span->f_offset < 0
+         || span->f_length != (int) strlen(expected)
+         || memcmp(host + span->f_offset, expected, span->f_length) != 0)
+    {
+        fprintf(stderr, "error: tld_split_domain(\"%s\") %s is %d/%d, expected \"%s\"\n",
+                    host, name, span->f_offset, span->f_length, expected);
+        ++err_count;
+    }
+}
+
+
+void test_split_domain()
+{
+    static const struct
+    {
+        const char *        f_host;
+        enum tld_result     f_result;
+        const char *        f_sub_domains;
+        const char *        f_domain;
+        const char *        f_tld;
+    } domains[] =
+    {
+        { "www.example.co.uk", TLD_RESULT_SUCCESS, "www", "example.co.uk", ".co.uk" },
+        { "example.co.uk", TLD_RESULT_SUCCESS, NULL, "example.co.uk", ".co.uk" },
+        { "a.b.c.m2osw.com", TLD_RESULT_SUCCESS, "a.b.c", "m2osw.com", ".com" },
+        { "sub-domain.www.ck", TLD_RESULT_SUCCESS, "sub-domain", "www.ck", ".ck" },
+        { "co.uk", TLD_RESULT_BAD_URI, NULL, NULL, NULL },
+        { "no-period", TLD_RESULT_NO_TLD, NULL, NULL, NULL },
+        { "double..period.com", TLD_RESULT_BAD_URI, NULL, NULL, NULL },
+    };
+    struct tld_domain_parts parts;
+    struct tld_info info;
+    enum tld_result r;
+    const char *domain;
+
+    for(size_t idx = 0; idx < sizeof(domains) / sizeof(domains[0]); ++idx)
+    {
+        r = tld_split_domain(domains[idx].f_host, strlen(domains[idx].f_host), &parts);
+        if(r != domains[idx].f_result)
+        {
+            fprintf(stderr, "error: tld_split_domain(\"%s\") returned %d, expected %d\n",
+                        domains[idx].f_host, r, domains[idx].f_result);
+            ++err_count;
+            continue;
+        }
+        check_span(domains[idx].f_host, "sub-domains", &parts.f_sub_domains, domains[idx].f_sub_domains);
+        check_span(domains[idx].f_host, "domain", &parts.f_domain, domains[idx].f_domain);
+        check_span(domains[idx].f_host, "TLD", &parts.f_tld, domains[idx].f_tld);
+    }
+
+    for(size_t idx = 0; idx < sizeof(g_uris) / sizeof(g_uris[0]); ++idx)
+    {
+        r = tld(g_uris[idx].f_uri, &info);
+        if(r != TLD_RESULT_SUCCESS || info.f_offset == 0)
+        {
+            continue;
+        }
+        domain = g_uris[idx].f_uri + info.f_offset;
+        while(domain > g_uris[idx].f_uri && domain[-1] != '.')
+        {
+            --domain;
+        }
+        r = tld_split_domain(g_uris[idx].f_uri, strlen(g_uris[idx].f_uri), &parts);
+        if(r != TLD_RESULT_SUCCESS)
+        {
+            fprintf(stderr, "error: tld_split_domain(\"%s\") returned %d, expected TLD_RESULT_SUCCESS\n",
+                        g_uris[idx].f_uri, r);
+            ++err_count;
+        }
+        else if(parts.f_tld.f_offset != info.f_offset
+             || parts.f_domain.f_offset != domain - g_uris[idx].f_uri
+             || (domain == g_uris[idx].f_uri
+                    ? parts.f_sub_domains.f_offset != -1
+                    : parts.f_sub_domains.f_length != domain - g_uris[idx].f_uri - 1))
+        {
+            fprintf(stderr, "error: tld_split_domain(\"%s\") did not return the same TLD as tld()\n",
+                        g_uris[idx].f_uri);
+            ++err_count;
+        }
+    }
+}
+
+
+/*
+ * This tests the tld_is_public_suffix() and tld_same_site() functions.
+ */
+void test_same_site()
+{
+    static const struct
+    {
+        const char *        f_host;
+        int                 f_public_suffix;
+    } suffixes[] =
+    {
+        { "com", 1 },
+        { "co.uk", 1 },
+        { ".co.uk", 1 },
+        { "com.ar", 1 },
+        { "anything.kawasaki.jp", 1 },
+        { "city.kawasaki.jp", 0 },
+        { "nacion.ar", 0 },
+        { "example.co.uk", 0 },
+        { "www.m2osw.com", 0 },
+        { "this-is-not-a-tld", 0 },
+        { "", 0 },
+        { ".", 0 },
+    };
+    static const struct
+    {
+        const char *        f_a;
+        const char *        f_b;
+        int                 f_same_site;
+    } sites[] =
+    {
+        { "www.example.co.uk", "example.co.uk", 1 },
+        { "a.example.co.uk", "b.c.example.co.uk", 1 },
+        { "www.m2osw.com", "m2osw.com", 1 },
+        { "www.nacion.ar", "nacion.ar", 1 },
+        { "example.co.uk", "example2.co.uk", 0 },
+        { "example.co.uk", "example.uk", 0 },
+        { "myexample.com", "example.com", 0 },
+        { "example.com", "myexample.com", 0 },
+        { "www.m2osw.com", "www.m2osw.net", 0 },
+        { "www.example.com", "www.example.org", 0 },
+        { "example.com", "com", 0 },
+        { "co.uk", "co.uk", 0 },
+        { "a.city.kawasaki.jp", "b.city.kawasaki.jp", 1 },
+        { "a.foo.kawasaki.jp", "b.foo.kawasaki.jp", 0 },
+        { "no-period", "no-period", 0 },
+    };
+    int r;
+
+    for(size_t idx = 0; idx < sizeof(suffixes) / sizeof(suffixes[0]); ++idx)
+    {
+        r = tld_is_public_suffix(suffixes[idx].f_host, strlen(suffixes[idx].f_host));
+        if(r != suffixes[idx].f_public_suffix)
+        {
+            fprintf(stderr, "error: tld_is_public_suffix(\"%s\") returned %d, expected %d\n",
+                        suffixes[idx].f_host, r, suffixes[idx].f_public_suffix);
+            ++err_count;
+        }
+    }
+    if(tld_is_public_suffix(NULL, 3) != 0)
+    {
+        fprintf(stderr, "error: tld_is_public_suffix(NULL) did not return 0\n");
+        ++err_count;
+    }
+
+    for(size_t idx = 0; idx < sizeof(sites) / sizeof(sites[0]); ++idx)
+    {
+        r = tld_same_site(sites[idx].f_a, strlen(sites[idx].f_a),
+                          sites[idx].f_b, strlen(sites[idx].f_b));
+        if(r != sites[idx].f_same_site)
+        {
+            fprintf(stderr, "error: tld_same_site(\"%s\", \"%s\") returned %d, expected %d\n",
+                        sites[idx].f_a, sites[idx].f_b, r, sites[idx].f_same_site);
+            ++err_count;
+        }
+        r = tld_same_site(sites[idx].f_b, strlen(sites[idx].f_b),
+                          sites[idx].f_a, strlen(sites[idx].f_a));
+        if(r != sites[idx].f_same_site)
+        {
+            fprintf(stderr, "error: tld_same_site(\"%s\", \"%s\") returned %d, expected %d\n",
+                        sites[idx].f_b, sites[idx].f_a, r, sites[idx].f_same_site);
+            ++err_count;
+        }
+    }
+    if(tld_same_site(NULL, 0, "m2osw.com", 9) != 0)
+    {
+        fprintf(stderr, "error: tld_same_site(NULL, ...) did not return 0\n");
+        ++err_count;
+    }
+}
+
+
+/*
+ * This tests the tld_wire() and tld_labels() functions. The domain names
+ * of g_uris are converted to the DNS wire format and the results are
+ * compared against tld().
+ */
+void test_wire()
+{
+    uint8_t wire[256];
+    struct tld_label labels[128];
+    struct tld_info info, info_wire, info_labels;
+    enum tld_result r, r_wire, r_labels;
+    const char *s, *e;
+    size_t length, count;
+    int suffix_label;
+
+    for(size_t idx = 0; idx < sizeof(g_uris) / sizeof(g_uris[0]); ++idx)
+    {
+        length = 0;
+        count = 0;
+        for(s = g_uris[idx].f_uri; count < sizeof(labels) / sizeof(labels[0]); s = e + 1)
+        {
+            e = strchr(s, '.');
+            if(e == NULL)
+            {
+                e = s + strlen(s);
+            }
+            if(e == s || e - s > 63 || length + (e - s) + 2 > sizeof(wire))
+            {
+                break;
+            }
+            labels[count].f_label = s;
+            labels[count].f_length = (int) (e - s);
+            ++count;
+            wire[length++] = (uint8_t) (e - s);
+            memcpy(wire + length, s, e - s);
+            length += e - s;
+            if(*e == '\0')
+            {
+                break;
+            }
+        }
+        if(*e != '\0' || e == s)
+        {
+            /* empty label or too long for DNS */
+            continue;
+        }
+        wire[length++] = 0;
+
+        r = tld(g_uris[idx].f_uri, &info);
+        r_wire = tld_wire(wire, length, &info_wire, &suffix_label);
+        r_labels = tld_labels(labels, count, &info_labels);
+        if(r != r_wire || r != r_labels)
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_wire() and tld_labels() got results %d and %d, expected %d\n",
+                        g_uris[idx].f_uri, r_wire, r_labels, r);
+            ++err_count;
+        }
+        else if(info.f_status != info_wire.f_status
+             || info.f_status != info_labels.f_status
+             || info.f_tld_index != info_wire.f_tld_index
+             || info.f_tld_index != info_labels.f_tld_index
+             || strcmp(info.f_country, info_wire.f_country) != 0
+             || (info.f_tld == NULL) != (info_wire.f_tld == NULL))
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_wire() and tld_labels() did not return the same info as tld()\n",
+                        g_uris[idx].f_uri);
+            ++err_count;
+        }
+        else if(info.f_tld != NULL
+             && (suffix_label != info_labels.f_offset
+                 || info_wire.f_tld != (const char *) wire + info_wire.f_offset
+                 || info_labels.f_tld != labels[suffix_label].f_label
+                 || (info.f_offset == 0
+                        ? suffix_label != 0
+                        : labels[suffix_label].f_label != g_uris[idx].f_uri + info.f_offset + 1)))
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_wire() and tld_labels() did not return the expected TLD position\n",
+                        g_uris[idx].f_uri);
+            ++err_count;
+        }
+    }
+
+    /* DNS names are case insensitive */
+    memcpy(wire, "\x03" "WwW" "\x05" "M2osw" "\x03" "COM" "\x00", 15);
+    r = tld_wire(wire, 15, &info_wire, &suffix_label);
+    if(r != TLD_RESULT_SUCCESS
+    || suffix_label != 2
+    || info_wire.f_offset != 10
+    || info_wire.f_category != TLD_CATEGORY_INTERNATIONAL)
+    {
+        fprintf(stderr, "error: tld_wire() did not find \".COM\" in \"WwW.M2osw.COM\" (%d, %d)\n", r, suffix_label);
+        ++err_count;
+    }
+
+    /* the root label is optional */
+    r = tld_wire(wire, 14, &info_wire, &suffix_label);
+    if(r != TLD_RESULT_SUCCESS
+    || suffix_label != 2)
+    {
+        fprintf(stderr, "error: tld_wire() without the root label returned %d\n", r);
+        ++err_count;
+    }
+
+    /* a label going past the end */
+    r = tld_wire(wire, 12, &info_wire, &suffix_label);
+    if(r != TLD_RESULT_BAD_URI
+    || suffix_label != -1)
+    {
+        fprintf(stderr, "error: tld_wire() with a truncated label returned %d instead of TLD_RESULT_BAD_URI\n", r);
+        ++err_count;
+    }
+
+    /* compression pointers are not supported */
+    memcpy(wire, "\x03" "www" "\xC0\x0C", 6);
+    r = tld_wire(wire, 6, &info_wire, NULL);
+    if(r != TLD_RESULT_BAD_URI)
+    {
+        fprintf(stderr, "error: tld_wire() with a compression pointer returned %d instead of TLD_RESULT_BAD_URI\n", r);
+        ++err_count;
+    }
+
+    /* one label is not enough */
+    r = tld_wire((const uint8_t *) "\x03" "com" "\x00", 5, &info_wire, NULL);
+    if(r != TLD_RESULT_NO_TLD)
+    {
+        fprintf(stderr, "error: tld_wire() with one label returned %d instead of TLD_RESULT_NO_TLD\n", r);
+        ++err_count;
+    }
+
+    r = tld_wire(NULL, 0, &info_wire, NULL);
+    if(r != TLD_RESULT_NULL)
+    {
+        fprintf(stderr, "error: tld_wire() with a NULL name returned %d instead of TLD_RESULT_NULL\n", r);
+        ++err_count;
+    }
+
+    /* an empty label is like two periods */
+    labels[0].f_label = "www";
+    labels[0].f_length = 3;
+    labels[1].f_label = "";
+    labels[1].f_length = 0;
+    labels[2].f_label = "com";
+    labels[2].f_length = 3;
+    r = tld_labels(labels, 3, &info_labels);
+    if(r != TLD_RESULT_BAD_URI)
+    {
+        fprintf(stderr, "error: tld_labels() with an empty label returned %d instead of TLD_RESULT_BAD_URI\n", r);
+        ++err_count;
+    }
+}
+
+
+/*
+ * This test verifies that tld_file_map() gives the same data as
+ * tld_file_load() and that it detects errors.
+ */
+void test_map()
+{
+    struct tld_file *   file = NULL;
+    enum tld_file_error err;
+
+    err = tld_file_map(g_filename1, &file);
+    if(err != TLD_FILE_ERROR_NONE)
+    {
+        err = tld_file_map(g_filename2, &file);
+    }
+    if(err != TLD_FILE_ERROR_NONE)
+    {
+        fprintf(stderr, "error: tld_file_map() could not map the TLD file: %s\n", tld_file_errstr(err));
+        ++err_count;
+        return;
+    }
+
+    if(file->f_mapping == NULL
+    || file->f_header->f_tld_max_level != g_tld_file->f_header->f_tld_max_level
+    || file->f_header->f_created_on != g_tld_file->f_header->f_created_on
+    || file->f_descriptions_count != g_tld_file->f_descriptions_count
+    || memcmp(file->f_descriptions, g_tld_file->f_descriptions, file->f_descriptions_count * sizeof(struct tld_description)) != 0
+    || file->f_tags_size != g_tld_file->f_tags_size
+    || memcmp(file->f_tags, g_tld_file->f_tags, file->f_tags_size * sizeof(uint32_t)) != 0
+    || file->f_strings_count != g_tld_file->f_strings_count
+    || file->f_strings_end - file->f_strings != g_tld_file->f_strings_end - g_tld_file->f_strings
+    || memcmp(file->f_strings, g_tld_file->f_strings, file->f_strings_end - file->f_strings) != 0)
+    {
+        fprintf(stderr, "error: tld_file_map() did not return the same data as tld_file_load()\n");
+        ++err_count;
+    }
+
+    /* the pointer must be null on entry */
+    err = tld_file_map(g_filename2, &file);
+    if(err != TLD_FILE_ERROR_POINTER_PRESENT)
+    {
+        fprintf(stderr, "error: tld_file_map() with a non-null file returned \"%s\"\n", tld_file_errstr(err));
+        ++err_count;
+    }
+
+    tld_file_free(&file);
+    if(file != NULL)
+    {
+        fprintf(stderr, "error: tld_file_free() did not reset the file pointer\n");
+        ++err_count;
+    }
+
+    err = tld_file_map(NULL, &file);
+    if(err != TLD_FILE_ERROR_INVALID_POINTER)
+    {
+        fprintf(stderr, "error: tld_file_map() with a NULL filename returned \"%s\"\n", tld_file_errstr(err));
+        ++err_count;
+    }
+
+    err = tld_file_map("/this/file/does/not/exist.tld", &file);
+    if(err != TLD_FILE_ERROR_CANNOT_OPEN_FILE)
+    {
+        fprintf(stderr, "error: tld_file_map() of a missing file returned \"%s\"\n", tld_file_errstr(err));
+        ++err_count;
+    }
+
+    /* this source file is not a TLD file */
+    err = tld_file_map("tld_test.c", &file);
+    if(err != TLD_FILE_ERROR_UNRECOGNIZED_FILE || file != NULL)
+    {
+        fprintf(stderr, "error: tld_file_map() of a C file returned \"%s\"\n", tld_file_errstr(err));
+        ++err_count;
+        tld_file_free(&file);
+    }
+}
+
+
+/*
+ * This test verifies that tld_file_load_buffer() uses the static TLDs
+ * in place and that it detects errors.
+ */
+void test_load_buffer()
+{
+    struct tld_file *   file = NULL;
+    enum tld_file_error err;
+    uint32_t            size;
+    uint8_t *           copy;
+
+    size = tld_get_static_tlds_buffer_size();
+    err = tld_file_load_buffer(tld_static_tlds, size, &file);
+    if(err != TLD_FILE_ERROR_NONE)
+    {
+        fprintf(stderr, "error: tld_file_load_buffer() of the static TLDs failed: %s\n", tld_file_errstr(err));
+        ++err_count;
+        return;
+    }
+
+    /* the data is used in place */
+    if((uint8_t const *) file->f_descriptions < tld_static_tlds
+    || (uint8_t const *) file->f_strings_end > tld_static_tlds + size
+    || file->f_mapping != NULL
+    || file->f_header->f_tld_max_level != g_tld_file->f_header->f_tld_max_level
+    || file->f_descriptions_count != g_tld_file->f_descriptions_count
+    || memcmp(file->f_descriptions, g_tld_file->f_descriptions, file->f_descriptions_count * sizeof(struct tld_description)) != 0)
+    {
+        fprintf(stderr, "error: tld_file_load_buffer() did not use the static TLDs in place\n");
+        ++err_count;
+    }
+    tld_file_free(&file);
+
+    err = tld_file_load_buffer(NULL, size, &file);
+    if(err != TLD_FILE_ERROR_INVALID_POINTER)
+    {
+        fprintf(stderr, "error: tld_file_load_buffer() with a NULL buffer returned \"%s\"\n", tld_file_errstr(err));
+        ++err_count;
+    }
+
+    /* a buffer that is too small */
+    err = tld_file_load_buffer(tld_static_tlds, size - 1, &file);
+    if(err != TLD_FILE_ERROR_CANNOT_READ_FILE || file != NULL)
+    {
+        fprintf(stderr, "error: tld_file_load_buffer() with a truncated buffer returned \"%s\"\n", tld_file_errstr(err));
+        ++err_count;
+        tld_file_free(&file);
+    }
+
+    /* a buffer that is not aligned */
+    copy = malloc(size + 1);
+    memcpy(copy + 1, tld_static_tlds, size);
+    err = tld_file_load_buffer(copy + 1, size, &file);
+    if(err != TLD_FILE_ERROR_INVALID_ALIGNMENT || file != NULL)
+    {
+        fprintf(stderr, "error: tld_file_load_buffer() with an unaligned buffer returned \"%s\"\n", tld_file_errstr(err));
+        ++err_count;
+        tld_file_free(&file);
+    }
+    free(copy);
+}
+
+
+/*
+ * This test verifies that a context created with tld_context_load()
+ * gives the same results as the default context.
+ */
+void test_context()
+{
+    struct tld_context *ctx1, *ctx2;
+    struct tld_info info, ctx_info;
+    struct tld_enumeration_state state, ctx_state;
+    struct tld_tag_definition tag, ctx_tag;
+    enum tld_result r, ctx_r;
+    size_t idx;
+    int count, ctx_count;
+
+    r = tld_context_load(NULL, 1, NULL);
+    if(r != TLD_RESULT_NULL)
+    {
+        fprintf(stderr, "error: tld_context_load() with a NULL context pointer returned %d, expected TLD_RESULT_NULL\n", r);
+        ++err_count;
+    }
+
+    ctx1 = (struct tld_context *) &info;
+    r = tld_context_load("/this/file/does/not/exist.tld", 0, &ctx1);
+    if(r != TLD_RESULT_NOT_FOUND || ctx1 != NULL)
+    {
+        fprintf(stderr, "error: tld_context_load() of a missing file returned %d, expected TLD_RESULT_NOT_FOUND and a NULL context\n", r);
+        ++err_count;
+    }
+
+    r = tld_ctx(NULL, "www.example.com", &info);
+    if(r != TLD_RESULT_NULL)
+    {
+        fprintf(stderr, "error: tld_ctx() with a NULL context returned %d, expected TLD_RESULT_NULL\n", r);
+        ++err_count;
+    }
+
+    /* two contexts can be used side by side */
+    r = tld_context_load(NULL, 1, &ctx1);
+    ctx_r = tld_context_load(NULL, 1, &ctx2);
+    if(r != TLD_RESULT_SUCCESS || ctx_r != TLD_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "error: tld_context_load() failed with %d and %d\n", r, ctx_r);
+        ++err_count;
+        return;
+    }
+
+    for(idx = 0; idx < sizeof(g_uris) / sizeof(g_uris[0]); ++idx)
+    {
+        r = tld(g_uris[idx].f_uri, &info);
+        ctx_r = tld_ctx(idx % 2 == 0 ? ctx1 : ctx2, g_uris[idx].f_uri, &ctx_info);
+        if(r != ctx_r
+        || info.f_offset != ctx_info.f_offset
+        || info.f_status != ctx_info.f_status
+        || info.f_category != ctx_info.f_category
+        || info.f_tld_index != ctx_info.f_tld_index
+        || info.f_tld != ctx_info.f_tld)
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_ctx() did not return the same result as tld()\n",
+                        g_uris[idx].f_uri);
+            ++err_count;
+        }
+
+        if(r == TLD_RESULT_SUCCESS
+        && tld_tag_count(&info) != tld_ctx_tag_count(ctx1, &ctx_info))
+        {
+            fprintf(stderr, "error: testing URI \"%s\" with tld_ctx_tag_count() did not return the same count as tld_tag_count()\n",
+                        g_uris[idx].f_uri);
+            ++err_count;
+        }
+
+        if(r == TLD_RESULT_SUCCESS
+        && tld_tag_count(&info) > 0)
+        {
+            r = tld_get_tag(&info, 0, &tag);
+            ctx_r = tld_ctx_get_tag(ctx2, &ctx_info, 0, &ctx_tag);
+            if(r != ctx_r
+            || tag.f_name_length != ctx_tag.f_name_length
+            || tag.f_value_length != ctx_tag.f_value_length
+            || memcmp(tag.f_name, ctx_tag.f_name, tag.f_name_length) != 0
+            || memcmp(tag.f_value, ctx_tag.f_value, tag.f_value_length) != 0)
+            {
+                fprintf(stderr, "error: testing URI \"%s\" with tld_ctx_get_tag() did not return the same tag as tld_get_tag()\n",
+                            g_uris[idx].f_uri);
+                ++err_count;
+            }
+        }
+    }
+
+    r = tld_check_uri("http://www.m2osw.com/libtld", &info, "http", 0);
+    ctx_r = tld_ctx_check_uri(ctx1, "http://www.m2osw.com/libtld", &ctx_info, "http", 0);
+    if(r != TLD_RESULT_SUCCESS
+    || ctx_r != TLD_RESULT_SUCCESS
+    || info.f_tld_index != ctx_info.f_tld_index)
+    {
+        fprintf(stderr, "error: tld_ctx_check_uri() returned %d, expected %d\n", ctx_r, r);
+        ++err_count;
+    }
+
+    /* the enumerations go through the same list */
+    memset(&state, 0, sizeof(state));
+    memset(&ctx_state, 0, sizeof(ctx_state));
+    count = 0;
+    while(tld_next_tld(&state, &info) != TLD_RESULT_NOT_FOUND)
+    {
+        ++count;
+    }
+    ctx_count = 0;
+    while(tld_ctx_next_tld(ctx2, &ctx_state, &ctx_info) != TLD_RESULT_NOT_FOUND)
+    {
+        ++ctx_count;
+    }
+    if(count != ctx_count)
+    {
+        fprintf(stderr, "error: tld_ctx_next_tld() enumerated %d TLDs, expected %d\n", ctx_count, count);
+        ++err_count;
+    }
+
+    /* the default context is not affected by the other contexts */
+    tld_context_free(ctx1);
+    tld_context_free(ctx2);
+    tld_context_free(NULL);
+
+    r = tld("www.m2osw.com", &info);
+    if(r != TLD_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "error: tld() failed with %d after the contexts were released\n", r);
+        ++err_count;
+    }
+}
+
+
+/*
+ * This test goes through all the domain names and extractsthe domain,
  * sub-domains and TLDs. (Or at least verifies that we get the correct
  * information in order to do so.)
  *
@@ -826,6 +1590,14 @@ int main(int argc, char *argv[])
      */
     load_tlds();
     test_specific();
+    test_slices();
+    test_lite();
+    test_split_domain();
+    test_same_site();
+    test_wire();
+    test_map();
+    test_load_buffer();
+    test_context();
     test_all();
     test_unknown();
     test_invalid();
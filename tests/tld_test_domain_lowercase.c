@@ -370,6 +370,52 @@ void test_invalid_xx()
 }
 
 
+void test_buffer()
+{
+    char buf[32], *r;
+    int len;
+
+    // same result as tld_domain_to_lowercase(), without the malloc()
+    len = tld_domain_to_lowercase_buffer("WWW.Caf\xC3\xA9.FR", buf, sizeof(buf));
+    r = tld_domain_to_lowercase("WWW.Caf\xC3\xA9.FR");
+    if(r == NULL
+    || len != (int) strlen(r)
+    || strcmp(buf, r) != 0
+    || strcmp(buf, "www.caf%C3%A9.fr") != 0)
+    {
+        ++err_count;
+        fprintf(stderr, "error: tld_domain_to_lowercase_buffer(\"WWW.Caf\xC3\xA9.FR\") returned %d \"%s\".\n", len, len < 0 ? "" : buf);
+    }
+    free(r);
+
+    // the buffer may be exactly the right size
+    len = tld_domain_to_lowercase_buffer("M2OSW.COM", buf, 10);
+    if(len != 9 || strcmp(buf, "m2osw.com") != 0)
+    {
+        ++err_count;
+        fprintf(stderr, "error: tld_domain_to_lowercase_buffer(\"M2OSW.COM\") with an exact buffer returned %d.\n", len);
+    }
+
+    // but not smaller
+    len = tld_domain_to_lowercase_buffer("M2OSW.COM", buf, 9);
+    if(len != -1)
+    {
+        ++err_count;
+        fprintf(stderr, "error: tld_domain_to_lowercase_buffer(\"M2OSW.COM\") with a small buffer returned %d instead of -1.\n", len);
+    }
+
+    // NULL or empty input, no buffer
+    if(tld_domain_to_lowercase_buffer(NULL, buf, sizeof(buf)) != -1
+    || tld_domain_to_lowercase_buffer("", buf, sizeof(buf)) != -1
+    || tld_domain_to_lowercase_buffer("m2osw.com", NULL, sizeof(buf)) != -1
+    || tld_domain_to_lowercase_buffer("m2osw.com", buf, 0) != -1)
+    {
+        ++err_count;
+        fprintf(stderr, "error: tld_domain_to_lowercase_buffer() with invalid parameters did not return -1.\n");
+    }
+}
+
+
 int main(int argc, char *argv[])
 {
     int i;
@@ -399,6 +445,7 @@ int main(int argc, char *argv[])
     test_empty();
     test_all_characters();
     test_invalid_xx();
+    test_buffer();
 
     exit(err_count ? 1 : 0);
 }
@@ -32,7 +32,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <atomic>
+#include <new>
 #include <sstream>
+#include <vector>
 
 /// The number of errors encountered before exiting.
 int err_count = 0;
@@ -40,6 +43,42 @@ int err_count = 0;
 /// Whether to be verbose, turned off by default.
 int verbose = 0;
 
+/// The number of times operator new was called, by any thread.
+std::atomic<size_t> g_new_count(0);
+
+
+/** \brief Count the allocations.
+ *
+ * This operator new replaces the default one so we can verify that
+ * a reused list of emails does not allocate memory anymore.
+ *
+ * \param[in] size  The number of bytes to allocate.
+ *
+ * \return A pointer to the new buffer.
+ */
+void * operator new(std::size_t size)
+{
+    ++g_new_count;
+    void * ptr(malloc(size == 0 ? 1 : size));
+    if(ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+
+void operator delete(void * ptr) noexcept
+{
+    free(ptr);
+}
+
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+    free(ptr);
+}
+
 
 /** \brief Print an error.
  *
@@ -827,6 +866,531 @@ void test_direct_email()
 }
 
 
+std::string view_to_string(const tld_string_span& view)
+{
+    return std::string(view.f_start, view.f_length);
+}
+
+
+void test_email_views()
+{
+    // the views must return the same results as the strings
+    //
+    const tld_email *results(list_of_results);
+    for(const valid_email *v(list_of_valid_emails); v->f_input_email != nullptr; ++v)
+    {
+        if(verbose)
+        {
+            printf("*** testing email views \"%s\"\n", email_to_vstring(v->f_input_email).c_str());
+            fflush(stdout);
+        }
+
+        struct tld_email_list *list(tld_email_alloc());
+        tld_result r(tld_email_parse_views(list, v->f_input_email, 0));
+        if(r != TLD_RESULT_SUCCESS)
+        {
+            error("error: unexpected return value from tld_email_parse_views() with [" + email_to_vstring(v->f_input_email) + "].");
+        }
+        else if(tld_email_count(list) != v->f_count)
+        {
+            error("error: unexpected count from tld_email_parse_views() with [" + email_to_vstring(v->f_input_email) + "].");
+        }
+        else
+        {
+            struct tld_email_view e;
+            for(int i(0); i < v->f_count; ++i, ++results)
+            {
+                if(tld_email_next_view(list, &e) != 1)
+                {
+                    error("error: tld_email_next_view() returned 0 too soon.");
+                    break;
+                }
+                if(view_to_string(e.f_group) != results->f_group
+                || view_to_string(e.f_original_email) != results->f_original_email
+                || view_to_string(e.f_fullname) != results->f_fullname
+                || view_to_string(e.f_username) != results->f_username
+                || view_to_string(e.f_domain) != results->f_domain
+                || view_to_string(e.f_email_only) != results->f_email_only
+                || view_to_string(e.f_canonicalized_email) != results->f_canonicalized_email)
+                {
+                    error("error: tld_email_next_view() returned the wrong email. Got \""
+                            + view_to_string(e.f_canonicalized_email) + "\" instead of \""
+                            + results->f_canonicalized_email + "\".");
+                }
+            }
+            if(tld_email_next_view(list, &e) != 0)
+            {
+                error("error: tld_email_next_view() returned 1 after the end of the list.");
+            }
+        }
+        tld_email_free(list);
+    }
+
+    // the original email is never copied and the email only too in the
+    // simple case, the rewritten canonicalized email is in the arena
+    //
+    {
+        const char *emails("alexis@m2osw.com, John <john@Example.Co.UK>");
+        const size_t length(strlen(emails));
+        tld_email_list list;
+        if(list.parse_views(emails, 0) != TLD_RESULT_SUCCESS
+        || list.count() != 2)
+        {
+            error("error: parse_views() failed with a simple list of emails.");
+        }
+        else
+        {
+            tld_email_view e;
+            if(!list.next(&e))
+            {
+                error("error: next() could not return the first view.");
+            }
+            else if(e.f_original_email.f_start != emails
+                 || e.f_email_only.f_start != emails
+                 || e.f_canonicalized_email.f_start != emails
+                 || e.f_email_only.f_length != 16)
+            {
+                error("error: the first email view was expected to point to the input.");
+            }
+            if(!list.next(&e))
+            {
+                error("error: next() could not return the second view.");
+            }
+            else if(e.f_original_email.f_start != emails + 18
+                 || e.f_domain.f_start != emails + 29
+                 || view_to_string(e.f_domain) != "Example.Co.UK"
+                 || (e.f_canonicalized_email.f_start >= emails && e.f_canonicalized_email.f_start < emails + length)
+                 || view_to_string(e.f_canonicalized_email) != "John <john@example.co.uk>")
+            {
+                error("error: the second email view is not as expected.");
+            }
+
+            // the string based functions still work after parse_views()
+            //
+            list.rewind();
+            tld_email_list::tld_email_t email;
+            if(!list.next(email)
+            || !list.next(email)
+            || email.f_email_only != "john@Example.Co.UK"
+            || email.f_canonicalized_email != "John <john@example.co.uk>")
+            {
+                error("error: next() did not return the expected email after parse_views().");
+            }
+        }
+    }
+
+    // a copy of a list filled by parse_views() does not depend on the
+    // input of the original list
+    //
+    {
+        std::string input("alexis@m2osw.com, John <john@Example.Co.UK>");
+        tld_email_list list;
+        if(list.parse_views(input.c_str(), input.length(), 0) != TLD_RESULT_SUCCESS)
+        {
+            error("error: parse_views() failed with the list to copy.");
+        }
+        tld_email_list copy(list);
+        tld_email_list assigned;
+        assigned = list;
+        input.assign(input.length(), 'x');
+
+        for(tld_email_list const * l : { &copy, &assigned })
+        {
+            tld_email_view e;
+            if(l->count() != 2
+            || !l->next(&e)
+            || view_to_string(e.f_original_email) != "alexis@m2osw.com"
+            || !l->next(&e)
+            || view_to_string(e.f_domain) != "Example.Co.UK"
+            || view_to_string(e.f_canonicalized_email) != "John <john@example.co.uk>"
+            || (e.f_domain.f_start >= input.c_str() && e.f_domain.f_start < input.c_str() + input.length()))
+            {
+                error("error: the copy of a list filled by parse_views() still points to the original input.");
+            }
+        }
+    }
+}
+
+
+
+void test_reuse()
+{
+    std::vector<std::string> inputs;
+    for(const valid_email *v(list_of_valid_emails); v->f_input_email != nullptr; ++v)
+    {
+        inputs.push_back(v->f_input_email);
+    }
+
+    // once the buffers are large enough, parsing does not allocate
+    // memory anymore with all three interfaces
+    //
+    tld_email_list list;
+    tld_email_list::tld_email_t e;
+    tld_email_view view;
+    struct tld_email_list *clist(tld_email_alloc());
+    struct tld_email ce;
+    for(int pass(0); pass < 3; ++pass)
+    {
+        const size_t new_count(g_new_count);
+        for(const auto & input : inputs)
+        {
+            if(list.parse(input, 0) != TLD_RESULT_SUCCESS)
+            {
+                error("error: parse() failed while reusing the list.");
+            }
+            while(list.next(e));
+
+            if(list.parse_views(input.c_str(), 0) != TLD_RESULT_SUCCESS)
+            {
+                error("error: parse_views() failed while reusing the list.");
+            }
+            while(list.next(&view));
+
+            if(tld_email_parse(clist, input.c_str(), 0) != TLD_RESULT_SUCCESS)
+            {
+                error("error: tld_email_parse() failed while reusing the list.");
+            }
+            while(tld_email_next(clist, &ce) == 1);
+        }
+        if(pass > 0 && g_new_count != new_count)
+        {
+            fprintf(stderr, "error: pass %d allocated memory %d times.\n", pass, static_cast<int>(g_new_count - new_count));
+            ++err_count;
+        }
+    }
+
+    // the last parse() was of the last input
+    //
+    if(list.count() != (list_of_valid_emails + inputs.size() - 1)->f_count)
+    {
+        error("error: the reused list does not have the expected number of emails.");
+    }
+
+    list.clear();
+    tld_email_clear(clist);
+    if(list.count() != 0
+    || list.next(e)
+    || tld_email_count(clist) != 0
+    || tld_email_next(clist, &ce) != 0)
+    {
+        error("error: the lists were not empty after a clear().");
+    }
+    tld_email_free(clist);
+}
+
+
+void test_long_lists()
+{
+    // the parser checks 16 characters at a time when possible, make sure
+    // the structural characters are found at any position
+    //
+    for(int pad(1); pad < 40; ++pad)
+    {
+        std::string const padding(pad, 'x');
+        std::string const list(
+                  "Team " + padding + ": \"" + padding + ", \\\"Jr.\\\"\" <a" + padding + "@m2osw.com>"
+                + ", b" + padding + "@m2osw.com (" + padding + " (nested, " + padding + ") )"
+                + "; d" + padding + "@m2osw.com");
+
+        tld_email_list emails;
+        if(emails.parse(list, 0) != TLD_RESULT_SUCCESS)
+        {
+            fprintf(stderr, "error: long list with padding %d was not accepted: \"%s\".\n", pad, list.c_str());
+            ++err_count;
+            continue;
+        }
+
+        // the group, 2 emails in the group, and the last email
+        //
+        tld_email_list::tld_email_t e;
+        if(emails.count() != 4
+        || !emails.next(e)
+        || e.f_group != "Team " + padding
+        || !emails.next(e)
+        || e.f_fullname != padding + ", \"Jr.\""
+        || e.f_email_only != "a" + padding + "@m2osw.com"
+        || !emails.next(e)
+        || e.f_email_only != "b" + padding + "@m2osw.com"
+        || !emails.next(e)
+        || e.f_email_only != "d" + padding + "@m2osw.com")
+        {
+            fprintf(stderr, "error: long list with padding %d was not parsed as expected: \"%s\".\n", pad, list.c_str());
+            ++err_count;
+        }
+
+        // unterminated quoted string, comment, and domain literal
+        //
+        char const * const invalid[] =
+        {
+            "\"",
+            "(",
+            "((x)",
+            "[",
+            "\"\\",
+        };
+        for(auto const & i : invalid)
+        {
+            std::string const bad("a" + padding + "@m2osw.com, " + padding + i + padding);
+            if(emails.parse(bad, 0) != TLD_RESULT_INVALID)
+            {
+                fprintf(stderr, "error: invalid long list with padding %d was accepted: \"%s\".\n", pad, bad.c_str());
+                ++err_count;
+            }
+        }
+    }
+}
+
+
+void test_domain_cache()
+{
+    // the results are the same with and without the cache, the second
+    // pass finds all the domains in the cache
+    //
+    tld_email_list cached;
+    cached.set_domain_cache_size(64);
+    if(cached.domain_cache_size() != 64)
+    {
+        error("error: the domain cache does not have the expected size.");
+    }
+    for(int pass(0); pass < 2; ++pass)
+    {
+        for(const valid_email *v(list_of_valid_emails); v->f_input_email != nullptr; ++v)
+        {
+            tld_email_list list;
+            if(list.parse(v->f_input_email, 0) != TLD_RESULT_SUCCESS
+            || cached.parse(v->f_input_email, 0) != TLD_RESULT_SUCCESS
+            || list.count() != cached.count())
+            {
+                fprintf(stderr, "error: parsing \"%s\" with a domain cache failed.\n", v->f_input_email);
+                ++err_count;
+                continue;
+            }
+            tld_email_list::tld_email_t e;
+            tld_email_list::tld_email_t c;
+            while(list.next(e))
+            {
+                if(!cached.next(c)
+                || e.f_group               != c.f_group
+                || e.f_original_email      != c.f_original_email
+                || e.f_fullname            != c.f_fullname
+                || e.f_username            != c.f_username
+                || e.f_domain              != c.f_domain
+                || e.f_email_only          != c.f_email_only
+                || e.f_canonicalized_email != c.f_canonicalized_email)
+                {
+                    fprintf(stderr, "error: email \"%s\" differs when parsed with a domain cache.\n", e.f_original_email.c_str());
+                    ++err_count;
+                }
+            }
+        }
+    }
+
+    // the domains are compared as found in the emails, also invalid
+    // domains get cached
+    //
+    struct tld_email_list *list(tld_email_alloc());
+    tld_email_set_domain_cache_size(list, 16);
+    if(tld_email_parse(list, "a@m2osw.com, b@M2OSW.com, c@m2osw.com, \"D\" <d@M2OSW.com>", 0) != TLD_RESULT_SUCCESS
+    || tld_email_domain_cache_hits(list) != 2
+    || tld_email_domain_cache_misses(list) != 2)
+    {
+        error("error: the domain cache did not count the expected hits and misses.");
+    }
+    struct tld_email e;
+    while(tld_email_next(list, &e) == 1)
+    {
+        if(strcmp(e.f_canonicalized_email + strlen(e.f_canonicalized_email) - 9, "m2osw.com") != 0
+        && strcmp(e.f_canonicalized_email + strlen(e.f_canonicalized_email) - 10, "m2osw.com>") != 0)
+        {
+            fprintf(stderr, "error: canonicalized email \"%s\" does not have its domain in lowercase.\n", e.f_canonicalized_email);
+            ++err_count;
+        }
+    }
+    for(int repeat(0); repeat < 2; ++repeat)
+    {
+        if(tld_email_parse(list, "a@m2osw.bad-tld", 0) != TLD_RESULT_NOT_FOUND)
+        {
+            error("error: the invalid domain was accepted.");
+        }
+    }
+    if(tld_email_domain_cache_hits(list) != 3
+    || tld_email_domain_cache_misses(list) != 3)
+    {
+        error("error: the invalid domain was not cached.");
+    }
+
+    // a size of 0 removes the cache
+    //
+    tld_email_set_domain_cache_size(list, 0);
+    if(tld_email_parse(list, "a@m2osw.com, b@m2osw.com", 0) != TLD_RESULT_SUCCESS
+    || tld_email_domain_cache_hits(list) != 0
+    || tld_email_domain_cache_misses(list) != 0)
+    {
+        error("error: the domain cache was used with a size of 0.");
+    }
+    tld_email_free(list);
+}
+
+
+void test_bulk()
+{
+    // one address per line, including lists, groups, invalid emails,
+    // and empty lines
+    //
+    std::vector<std::string> lines;
+    for(const valid_email *v(list_of_valid_emails); v->f_input_email != nullptr; ++v)
+    {
+        if(strchr(v->f_input_email, '\n') == nullptr)
+        {
+            lines.push_back(v->f_input_email);
+        }
+    }
+    for(const invalid_email *v(list_of_invalid_emails); v->f_input_email != nullptr; ++v)
+    {
+        if(strchr(v->f_input_email, '\n') == nullptr)
+        {
+            lines.push_back(v->f_input_email);
+        }
+    }
+    lines.push_back("");
+    lines.push_back(" \t ");
+    lines.push_back("Alexis <alexis@M2OSW.COM>\r");
+
+    // make it large enough to use many threads
+    //
+    std::string buffer;
+    std::vector<std::string> expected_lines;
+    char const * const separators[] = { "\n", "\r\n", "" };
+    for(size_t idx(0); buffer.length() < 1024 * 1024; ++idx)
+    {
+        std::string const & line(lines[idx % lines.size()]);
+        char const * sep(separators[idx % 3]);
+        buffer += line;
+        if(*sep == '\0')
+        {
+            buffer += '\0';
+        }
+        else
+        {
+            buffer += sep;
+        }
+        expected_lines.push_back(line + (sep[0] == '\r' ? "\r" : ""));
+    }
+
+    // the sequential results
+    //
+    struct expected_t
+    {
+        tld_result          f_result = TLD_RESULT_NULL;
+        std::string         f_domain = std::string();
+        std::string         f_canonicalized_email = std::string();
+    };
+    std::vector<expected_t> expected;
+    for(auto const & line : expected_lines)
+    {
+        expected_t r;
+        if(line.find_first_not_of(" \t\r") != std::string::npos)
+        {
+            tld_email_list list;
+            r.f_result = list.parse(line, 0);
+            if(r.f_result == TLD_RESULT_SUCCESS)
+            {
+                tld_email_list::tld_email_t e;
+                if(list.count() != 1
+                || !list.next(e)
+                || !e.f_group.empty())
+                {
+                    r.f_result = TLD_RESULT_INVALID;
+                }
+                else
+                {
+                    r.f_domain = e.f_domain;
+                    r.f_canonicalized_email = e.f_canonicalized_email;
+                }
+            }
+        }
+        expected.push_back(r);
+    }
+
+    auto check = [&expected](char const * name, int threads, tld_result result, size_t count, tld_email_bulk_result const * results)
+        {
+            if(result != TLD_RESULT_INVALID
+            || count != expected.size())
+            {
+                fprintf(stderr, "error: %s bulk validation with %d threads returned %d and %d results instead of %d.\n",
+                        name, threads, static_cast<int>(result), static_cast<int>(count), static_cast<int>(expected.size()));
+                ++err_count;
+                return;
+            }
+            for(size_t idx(0); idx < count; ++idx)
+            {
+                tld_email_bulk_result const & r(results[idx]);
+                if(r.f_result != expected[idx].f_result
+                || std::string(r.f_domain.f_start == nullptr ? "" : r.f_domain.f_start, r.f_domain.f_length) != expected[idx].f_domain
+                || std::string(r.f_canonicalized_email.f_start == nullptr ? "" : r.f_canonicalized_email.f_start, r.f_canonicalized_email.f_length) != expected[idx].f_canonicalized_email)
+                {
+                    fprintf(stderr, "error: %s bulk validation with %d threads differs at line %d.\n",
+                            name, threads, static_cast<int>(idx));
+                    ++err_count;
+                    return;
+                }
+            }
+        };
+
+    tld_email_bulk bulk;
+    for(int threads : { 1, 2, 3, 8, 0 })
+    {
+        bulk.set_thread_count(threads);
+        tld_result const result(bulk.validate(buffer.data(), buffer.length(), 0));
+        check("C++", threads, result, bulk.count(), bulk.results());
+    }
+
+    // without the last separator
+    //
+    {
+        bulk.set_thread_count(4);
+        tld_result const result(bulk.validate(buffer.data(), buffer.length() - 1, 0));
+        check("C++", 4, result, bulk.count(), bulk.results());
+    }
+
+    // C version, with a cache of domains
+    //
+    struct tld_email_bulk *cbulk(tld_email_bulk_alloc());
+    tld_email_bulk_set_thread_count(cbulk, 4);
+    tld_email_bulk_set_domain_cache_size(cbulk, 64);
+    for(int repeat(0); repeat < 2; ++repeat)
+    {
+        tld_result const result(tld_email_bulk_validate(cbulk, buffer.data(), buffer.length(), 0));
+        check("C", 4, result, tld_email_bulk_count(cbulk), tld_email_bulk_results(cbulk));
+    }
+
+    // small buffers
+    //
+    if(tld_email_bulk_validate(cbulk, "alexis@m2osw.com\nJohn <john@m2osw.com>", 38, 0) != TLD_RESULT_SUCCESS
+    || tld_email_bulk_count(cbulk) != 2
+    || tld_email_bulk_validate(cbulk, "", 0, 0) != TLD_RESULT_SUCCESS
+    || tld_email_bulk_count(cbulk) != 0
+    || tld_email_bulk_validate(cbulk, nullptr, 0, 0) != TLD_RESULT_NULL
+    || tld_email_bulk_count(cbulk) != 0)
+    {
+        error("error: bulk validation of small buffers failed.");
+    }
+
+    // a blank line ending with "\r\n" is an empty line
+    //
+    char const blank_lines[] = "alexis@m2osw.com\r\n\r\n  \r\njohn@m2osw.com\r\n";
+    if(tld_email_bulk_validate(cbulk, blank_lines, sizeof(blank_lines) - 1, 0) != TLD_RESULT_INVALID
+    || tld_email_bulk_count(cbulk) != 4
+    || tld_email_bulk_results(cbulk)[0].f_result != TLD_RESULT_SUCCESS
+    || tld_email_bulk_results(cbulk)[1].f_result != TLD_RESULT_NULL
+    || tld_email_bulk_results(cbulk)[2].f_result != TLD_RESULT_NULL
+    || tld_email_bulk_results(cbulk)[3].f_result != TLD_RESULT_SUCCESS)
+    {
+        error("error: bulk validation of blank \"\\r\\n\" lines failed.");
+    }
+    tld_email_bulk_free(cbulk);
+}
+
 
 /** \brief Structure used to define a set of fields to test.
  *
@@ -953,6 +1517,11 @@ int main(int argc, char *argv[])
         test_valid_emails();
         test_invalid_emails();
         test_direct_email();
+        test_email_views();
+        test_reuse();
+        test_long_lists();
+        test_domain_cache();
+        test_bulk();
         test_email_field_types();
     }
     catch(const invalid_domain&)
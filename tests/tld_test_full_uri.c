@@ -377,7 +377,7 @@ const struct test_info test_info_entries[] =
       { TLD_CATEGORY_UNDEFINED, TLD_STATUS_UNDEFINED, "", NULL, -1, 0 }
     },
     {
-      "http://a--really--long--domain-name--is-actually--forbidden.this--is--done-by--checking--the--length--which--is--limited--to--two--hundred--and--fifty--six--characters.note--that--the--buffer--must--include--a--null--terminator--which--means--you--really--are--limited--to--255--characters.www.m2osw.no/large/characters\xF0/forbidden",
+      "http://www.m2osw%2E.co.uk/encoded/double/period",
       PROTOCOLS,
       0,
       TLD_RESULT_BAD_URI,
@@ -412,6 +412,20 @@ const struct test_info test_info_entries[] =
       TLD_RESULT_SUCCESS,
       { TLD_CATEGORY_COUNTRY, TLD_STATUS_VALID, "Oman", ".edu.om", 23, 0 }
     },
+    {
+      "http://www%2Em2osw%2Eco.uk/encoded/periods/before/tld",
+      PROTOCOLS,
+      0,
+      TLD_RESULT_SUCCESS,
+      { TLD_CATEGORY_COUNTRY, TLD_STATUS_VALID, "United Kingdom", "%2Eco.uk/", 18, 0 }
+    },
+    {
+      "http://a--really--long--domain-name--is-accepted.the--length--used--to--be--limited--to--two--hundred--and--fifty--five--characters.because--the--domain--was--copied--in--a--buffer--before--searching--the--tld.this--is--not--the--case--anymore--so--longer--domain--names--work.www.m2osw.no/large/characters\xF0/accepted",
+      PROTOCOLS,
+      0,
+      TLD_RESULT_SUCCESS,
+      { TLD_CATEGORY_COUNTRY, TLD_STATUS_VALID, "Norway", ".no/large/", 286, 0 }
+    },
     {
       "ftp://www.m2osw.ltd%2euk/encoded/period", /* still encoded */
       PROTOCOLS,
@@ -530,11 +544,339 @@ void test_uri()
     }
 }
 
+/*
+ * Verify that tld_check_uri_n() returns the same results as
+ * tld_check_uri() when the URI is followed by more data in the buffer.
+ */
+void test_uri_n()
+{
+    char buffer[1024];
+    struct tld_info info, info_n;
+    enum tld_result result, result_n;
+    size_t i, length;
+
+    for(i = 0; i < test_info_entries_length; ++i)
+    {
+        if(test_info_entries[i].f_uri == NULL)
+        {
+            continue;
+        }
+        length = strlen(test_info_entries[i].f_uri);
+        if(length + 4 > sizeof(buffer))
+        {
+            continue;
+        }
+        memcpy(buffer, test_info_entries[i].f_uri, length);
+        memcpy(buffer + length, "\x01%?", 4);
+
+        result = tld_check_uri(test_info_entries[i].f_uri, &info, test_info_entries[i].f_protocols, test_info_entries[i].f_flags);
+        result_n = tld_check_uri_n(buffer, length, &info_n, test_info_entries[i].f_protocols, test_info_entries[i].f_flags);
+        if(result != result_n)
+        {
+            fprintf(stderr, "error:%s: tld_check_uri_n() returned %d, expected %d.\n", test_info_entries[i].f_uri, result_n, result);
+            ++err_count;
+        }
+        else if(result == TLD_RESULT_SUCCESS
+             && (info.f_offset != info_n.f_offset
+              || info.f_category != info_n.f_category
+              || info.f_status != info_n.f_status
+              || info_n.f_tld != buffer + info_n.f_offset
+              || strcmp(info.f_country, info_n.f_country) != 0))
+        {
+            fprintf(stderr, "error:%s: tld_check_uri_n() did not return the same info as tld_check_uri().\n", test_info_entries[i].f_uri);
+            ++err_count;
+        }
+    }
+
+    result = tld_check_uri_n("http://www.m2osw.com/", 0, &info, "http", 0);
+    if(result != TLD_RESULT_NULL)
+    {
+        fprintf(stderr, "error: tld_check_uri_n() with a zero length returned %d instead of TLD_RESULT_NULL.\n", result);
+        ++err_count;
+    }
+
+    // the length includes the '\0' which is viewed as a control character
+    //
+    result = tld_check_uri_n("http://www.m2osw.com/", 22, &info, "http", 0);
+    if(result != TLD_RESULT_BAD_URI)
+    {
+        fprintf(stderr, "error: tld_check_uri_n() with a '\\0' in the path returned %d instead of TLD_RESULT_BAD_URI.\n", result);
+        ++err_count;
+    }
+}
+
+
+/*
+ * Verify that tld_check_uri_ex() returns the same results as
+ * tld_check_uri() with the compiled version of the same protocols.
+ */
+void test_uri_ex()
+{
+    struct tld_protocols *protocols;
+    struct tld_info info, info_ex;
+    enum tld_result result, result_ex;
+    size_t i;
+
+    for(i = 0; i < test_info_entries_length; ++i)
+    {
+        if(test_info_entries[i].f_uri == NULL)
+        {
+            continue;
+        }
+        protocols = tld_protocols_compile(test_info_entries[i].f_protocols);
+        if(protocols == NULL)
+        {
+            fprintf(stderr, "error:%s: tld_protocols_compile() failed.\n", test_info_entries[i].f_protocols);
+            ++err_count;
+            continue;
+        }
+
+        result = tld_check_uri(test_info_entries[i].f_uri, &info, test_info_entries[i].f_protocols, test_info_entries[i].f_flags);
+        result_ex = tld_check_uri_ex(test_info_entries[i].f_uri, strlen(test_info_entries[i].f_uri), &info_ex, protocols, test_info_entries[i].f_flags);
+        if(result != result_ex)
+        {
+            fprintf(stderr, "error:%s: tld_check_uri_ex() returned %d, expected %d.\n", test_info_entries[i].f_uri, result_ex, result);
+            ++err_count;
+        }
+        else if(info.f_offset != info_ex.f_offset
+             || info.f_tld != info_ex.f_tld
+             || info.f_category != info_ex.f_category
+             || info.f_status != info_ex.f_status
+             || strcmp(info.f_country, info_ex.f_country) != 0)
+        {
+            fprintf(stderr, "error:%s: tld_check_uri_ex() did not return the same info as tld_check_uri().\n", test_info_entries[i].f_uri);
+            ++err_count;
+        }
+
+        tld_protocols_free(protocols);
+    }
+
+    /* various lists of protocols */
+    {
+        struct protocols_t
+        {
+            const char *        f_protocols;
+            const char *        f_uri;
+            enum tld_result     f_result;
+        };
+        static const struct protocols_t lists[] =
+        {
+            { "http,https",             "http://www.m2osw.com/",    TLD_RESULT_SUCCESS },
+            { "http,https",             "HTTPS://www.m2osw.com/",   TLD_RESULT_SUCCESS },
+            { "HTTP,Https",             "https://www.m2osw.com/",   TLD_RESULT_SUCCESS },
+            { "http,https",             "ftp://www.m2osw.com/",     TLD_RESULT_BAD_URI },
+            { "http,https",             "htt://www.m2osw.com/",     TLD_RESULT_BAD_URI },
+            { "http,https",             "httpss://www.m2osw.com/",  TLD_RESULT_BAD_URI },
+            { "http,https",             "://www.m2osw.com/",        TLD_RESULT_BAD_URI },
+            { ",,ftp,,http,,",          "http://www.m2osw.com/",    TLD_RESULT_SUCCESS },
+            { "http,http,http,ftp",     "ftp://www.m2osw.com/",     TLD_RESULT_SUCCESS },
+            { "",                       "http://www.m2osw.com/",    TLD_RESULT_BAD_URI },
+            { "ftp,*",                  "gopher://www.m2osw.com/",  TLD_RESULT_SUCCESS },
+            { "a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q,r,s,t,u,v,w,x,y,z,a1,b1,c1,d1,e1,f1,g1,h1",
+                                        "g1://www.m2osw.com/",      TLD_RESULT_SUCCESS },
+            { "a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q,r,s,t,u,v,w,x,y,z,a1,b1,c1,d1,e1,f1,g1,h1",
+                                        "i1://www.m2osw.com/",      TLD_RESULT_BAD_URI },
+        };
+
+        for(i = 0; i < sizeof(lists) / sizeof(lists[0]); ++i)
+        {
+            protocols = tld_protocols_compile(lists[i].f_protocols);
+            result = tld_check_uri(lists[i].f_uri, &info, lists[i].f_protocols, 0);
+            result_ex = tld_check_uri_ex(lists[i].f_uri, strlen(lists[i].f_uri), &info_ex, protocols, 0);
+            if(result != lists[i].f_result
+            || result_ex != lists[i].f_result)
+            {
+                fprintf(stderr, "error:%s: with protocols \"%s\" returned %d and %d, expected %d.\n",
+                                lists[i].f_uri, lists[i].f_protocols, result, result_ex, lists[i].f_result);
+                ++err_count;
+            }
+            tld_protocols_free(protocols);
+        }
+    }
+
+    if(tld_protocols_compile(NULL) != NULL)
+    {
+        fprintf(stderr, "error: tld_protocols_compile(NULL) did not return NULL.\n");
+        ++err_count;
+    }
+
+    result = tld_check_uri_ex("http://www.m2osw.com/", 21, &info, NULL, 0);
+    if(result != TLD_RESULT_BAD_URI)
+    {
+        fprintf(stderr, "error: tld_check_uri_ex() with NULL protocols returned %d instead of TLD_RESULT_BAD_URI.\n", result);
+        ++err_count;
+    }
+
+    tld_protocols_free(NULL);
+}
 
+/*
+ * Verify one part returned by tld_check_uri_parts().
+ */
+void check_part(const char *uri, const char *name, const struct tld_span *span, const char *expected)
+{
+    if(expected == NULL)
+    {
+        if(span->f_offset != -1 || span->f_length != 0)
+        {
+            fprintf(stderr, "error:%s: %s was expected to be absent, got offset %d and length %d.\n",
+                            uri, name, span->f_offset, span->f_length);
+            ++err_count;
+        }
+    }
+    else if(span->f_offset < 0
+         || (size_t) span->f_length != strlen(expected)
+         || strncmp(uri + span->f_offset, expected, span->f_length) != 0)
+    {
+        fprintf(stderr, "error:%s: %s was expected to be \"%s\", got offset %d and length %d.\n",
+                        uri, name, expected, span->f_offset, span->f_length);
+        ++err_count;
+    }
+}
 
+/*
+ * Verify that tld_check_uri_parts() returns the expected parts.
+ */
+void test_uri_parts()
+{
+    struct parts_t
+    {
+        const char *        f_uri;
+        enum tld_result     f_result;
+        const char *        f_protocol;
+        const char *        f_username;
+        const char *        f_password;
+        const char *        f_host;
+        const char *        f_sub_domains;
+        const char *        f_domain;
+        const char *        f_tld;
+        const char *        f_port;
+        const char *        f_path;
+        const char *        f_query_string;
+        const char *        f_anchor;
+    };
+    static const struct parts_t uris[] =
+    {
+        {
+            "https://me:pw@www.m2osw.co.uk:8080/a/b?x=1&y=2#top", TLD_RESULT_SUCCESS,
+            "https", "me", "pw", "www.m2osw.co.uk", "www", "m2osw.co.uk", ".co.uk", "8080", "/a/b", "x=1&y=2", "top"
+        },
+        {
+            "http://m2osw.com", TLD_RESULT_SUCCESS,
+            "http", NULL, NULL, "m2osw.com", NULL, "m2osw.com", ".com", NULL, NULL, NULL, NULL
+        },
+        {
+            "HTTP://user@a.b.c.m2osw.com/#anchor?not-a-query", TLD_RESULT_SUCCESS,
+            "HTTP", "user", NULL, "a.b.c.m2osw.com", "a.b.c", "m2osw.com", ".com", NULL, "/", NULL, "anchor?not-a-query"
+        },
+        {
+            "ftp://www%2Em2osw%2Eco.uk/?", TLD_RESULT_SUCCESS,
+            "ftp", NULL, NULL, "www%2Em2osw%2Eco.uk", "www", "m2osw%2Eco.uk", "%2Eco.uk", NULL, "/", "", NULL
+        },
+        {
+            "http://nacion.ar/path#", TLD_RESULT_SUCCESS,
+            "http", NULL, NULL, "nacion.ar", NULL, "nacion.ar", ".ar", NULL, "/path", NULL, ""
+        },
+        {
+            "http://www.m2osw.com:/", TLD_RESULT_BAD_URI,
+            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+        },
+        {
+            "http://www.m2osw.this-is-not-a-tld/", TLD_RESULT_NOT_FOUND,
+            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+        },
+    };
+    struct tld_protocols *protocols;
+    struct tld_uri_parts parts;
+    struct tld_info info;
+    enum tld_result result;
+    size_t i;
 
+    protocols = tld_protocols_compile("ftp,http,https");
+    for(i = 0; i < sizeof(uris) / sizeof(uris[0]); ++i)
+    {
+        result = tld_check_uri_parts(uris[i].f_uri, strlen(uris[i].f_uri), &info, protocols, 0, &parts);
+        if(result != uris[i].f_result)
+        {
+            fprintf(stderr, "error:%s: tld_check_uri_parts() returned %d, expected %d.\n", uris[i].f_uri, result, uris[i].f_result);
+            ++err_count;
+            continue;
+        }
+        check_part(uris[i].f_uri, "protocol", &parts.f_protocol, uris[i].f_protocol);
+        check_part(uris[i].f_uri, "username", &parts.f_username, uris[i].f_username);
+        check_part(uris[i].f_uri, "password", &parts.f_password, uris[i].f_password);
+        check_part(uris[i].f_uri, "host", &parts.f_host, uris[i].f_host);
+        check_part(uris[i].f_uri, "sub-domains", &parts.f_sub_domains, uris[i].f_sub_domains);
+        check_part(uris[i].f_uri, "domain", &parts.f_domain, uris[i].f_domain);
+        check_part(uris[i].f_uri, "tld", &parts.f_tld, uris[i].f_tld);
+        check_part(uris[i].f_uri, "port", &parts.f_port, uris[i].f_port);
+        check_part(uris[i].f_uri, "path", &parts.f_path, uris[i].f_path);
+        check_part(uris[i].f_uri, "query string", &parts.f_query_string, uris[i].f_query_string);
+        check_part(uris[i].f_uri, "anchor", &parts.f_anchor, uris[i].f_anchor);
+        if(result == TLD_RESULT_SUCCESS
+        && parts.f_tld.f_offset != info.f_offset)
+        {
+            fprintf(stderr, "error:%s: the tld part offset (%d) is not the same as tld_info::f_offset (%d).\n",
+                            uris[i].f_uri, parts.f_tld.f_offset, info.f_offset);
+            ++err_count;
+        }
+    }
+    tld_protocols_free(protocols);
+}
 
+/*
+ * Verify that the special characters are found at any position in a
+ * long path; the path is checked by blocks of characters so each
+ * position within a block gets tested.
+ */
+void test_long_path()
+{
+    struct special_t
+    {
+        const char *        f_special;
+        int                 f_flags;
+        enum tld_result     f_result;
+    };
+    static const struct special_t specials[] =
+    {
+        { "\x01",   0,                      TLD_RESULT_BAD_URI },
+        { " ",      0,                      TLD_RESULT_SUCCESS },
+        { " ",      VALID_URI_NO_SPACES,    TLD_RESULT_BAD_URI },
+        { "+",      VALID_URI_NO_SPACES,    TLD_RESULT_BAD_URI },
+        { "\xE9",   0,                      TLD_RESULT_SUCCESS },
+        { "\xE9",   VALID_URI_ASCII_ONLY,   TLD_RESULT_BAD_URI },
+        { "&",      0,                      TLD_RESULT_BAD_URI },
+        { "?=",     0,                      TLD_RESULT_BAD_URI },
+        { "%41",    0,                      TLD_RESULT_SUCCESS },
+        { "%zz",    0,                      TLD_RESULT_BAD_URI },
+        { "%20",    VALID_URI_NO_SPACES,    TLD_RESULT_BAD_URI },
+    };
+    char uri[256];
+    struct tld_info info;
+    enum tld_result result;
+    size_t i, pos, length;
 
+    for(i = 0; i < sizeof(specials) / sizeof(specials[0]); ++i)
+    {
+        for(pos = 0; pos < 64; ++pos)
+        {
+            strcpy(uri, "http://www.m2osw.com/");
+            length = strlen(uri);
+            memset(uri + length, 'a', pos);
+            uri[length + pos] = '\0';
+            strcat(uri, specials[i].f_special);
+            strcat(uri, "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb");
+
+            result = tld_check_uri(uri, &info, "http", specials[i].f_flags);
+            if(result != specials[i].f_result)
+            {
+                fprintf(stderr, "error:%s: long path with a special character at %d returned %d, expected %d.\n",
+                                uri, (int) pos, result, specials[i].f_result);
+                ++err_count;
+            }
+        }
+    }
+}
 
 
 
@@ -557,6 +899,10 @@ int main(int argc, char *argv[])
      */
     load_tlds();
     test_uri();
+    test_uri_n();
+    test_uri_ex();
+    test_uri_parts();
+    test_long_path();
 
     if(err_count)
     {
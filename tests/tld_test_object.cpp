@@ -125,6 +125,60 @@ void test_valid_uri(const char *uri, const char *tld, const char *domain, const
     {
         error("error: o.country() of \"" + std::string(uri) + "\" result was not valid.");
     }
+
+    // create object with a slice of a larger buffer
+    std::string const buffer(std::string(uri) + ".invalid-tld");
+    tld_object v(std::string_view(buffer.data(), strlen(uri)));
+
+    if(!v.is_valid())
+    {
+        error("error: v.is_valid() of \"" + std::string(uri) + "\" (string_view) result is not true.");
+        return;
+    }
+
+    if(v.domain() != uri)
+    {
+        error("error: v.domain() of \"" + std::string(uri) + "\" (string_view) result was not valid.");
+    }
+
+    if(v.full_domain() != domain + std::string(tld))
+    {
+        error("error: v.full_domain() of \"" + std::string(uri) + "\" (string_view) result was not valid.");
+    }
+
+    if(v.category() != category)
+    {
+        error("error: v.category() of \"" + std::string(uri) + "\" (string_view) result was not valid.");
+    }
+
+    // split the same slice without creating an object
+    tld_domain_views views;
+    if(tld_split_domain(std::string_view(buffer.data(), strlen(uri)), &views) != TLD_RESULT_SUCCESS)
+    {
+        error("error: tld_split_domain() of \"" + std::string(uri) + "\" did not return TLD_RESULT_SUCCESS.");
+        return;
+    }
+
+    if(views.f_sub_domains != sub_domains)
+    {
+        error("error: tld_split_domain() sub-domains of \"" + std::string(uri) + "\" result was not valid.");
+    }
+
+    if(views.f_domain != domain + std::string(tld))
+    {
+        error("error: tld_split_domain() domain of \"" + std::string(uri) + "\" result was not valid.");
+    }
+
+    if(views.f_tld != tld)
+    {
+        error("error: tld_split_domain() TLD of \"" + std::string(uri) + "\" result was not valid.");
+    }
+
+    if(views.f_domain.data() < buffer.data()
+    || views.f_domain.data() >= buffer.data() + buffer.length())
+    {
+        error("error: tld_split_domain() domain of \"" + std::string(uri) + "\" does not point in the input buffer.");
+    }
 }
 
 
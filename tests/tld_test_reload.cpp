@@ -0,0 +1,265 @@
+/* TLD library -- test reloading the TLDs while threads run lookups
+ * Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** \file
+ * \brief Test the tld_reload_tlds() function.
+ *
+ * This file runs lookups on many threads while the main thread reloads
+ * the TLDs in a loop. The lookups are expected to always return the
+ * same results as before the reloads started.
+ *
+ * Run this test under valgrind or with the address sanitizer to verify
+ * that the previous TLDs do not get released while still in use.
+ */
+
+#include    "libtld/tld.h"
+
+// C++
+//
+#include    <atomic>
+#include    <string>
+#include    <thread>
+#include    <vector>
+
+
+// C
+//
+#include    <stdlib.h>
+#include    <stdio.h>
+#include    <string.h>
+
+
+
+std::atomic<int> err_count(0);
+int verbose = 0;
+
+
+char const * const g_domains[] =
+{
+    "www.m2osw.com",
+    "test-with-a-dash.mat.br",
+    "test.valid.uri.domain.com.ac",
+    "sub-domain.www.ck",
+    "www.example.co.uk",
+    "img-03.static.eu-west-1.edge.cdn.example.kawasaki.jp",
+    "no-such-tld.this-is-not-a-tld",
+    "no-period",
+};
+
+
+struct expected_t
+{
+    tld_result      f_result = TLD_RESULT_SUCCESS;
+    int             f_offset = -1;
+    int             f_tld_index = -1;
+    std::string     f_country = std::string();
+};
+
+
+std::vector<expected_t> g_expected;
+
+
+void error(char const * domain, char const * msg)
+{
+    fprintf(stderr, "error: \"%s\" %s.\n", domain, msg);
+    ++err_count;
+}
+
+
+void load_expected()
+{
+    for(auto const d : g_domains)
+    {
+        expected_t e;
+        tld_info info;
+        e.f_result = tld(d, &info);
+        e.f_offset = info.f_offset;
+        e.f_tld_index = info.f_tld_index;
+        e.f_country = info.f_country;
+        g_expected.push_back(e);
+    }
+}
+
+
+void lookup(std::atomic<bool> const & done, std::atomic<long> & count)
+{
+    std::size_t const max(sizeof(g_domains) / sizeof(g_domains[0]));
+    long local_count(0);
+
+    while(!done.load())
+    {
+        for(std::size_t idx(0); idx < max; ++idx)
+        {
+            tld_info info;
+            tld_result const r(tld(g_domains[idx], &info));
+            if(r != g_expected[idx].f_result
+            || info.f_offset != g_expected[idx].f_offset
+            || info.f_tld_index != g_expected[idx].f_tld_index)
+            {
+                error(g_domains[idx], "did not return the expected result while reloading");
+            }
+        }
+
+        tld_info info;
+        if(tld_check_uri("https://www.m2osw.com/", &info, "http,https", 0) != TLD_RESULT_SUCCESS
+        || info.f_tld_index != g_expected[0].f_tld_index)
+        {
+            error("https://www.m2osw.com/", "was not accepted by tld_check_uri() while reloading");
+        }
+
+        local_count += max + 1;
+    }
+
+    count += local_count;
+}
+
+
+void test_reload(int thread_count, int reload_count)
+{
+    std::atomic<bool> done(false);
+    std::atomic<long> count(0);
+    std::vector<std::thread> threads;
+
+    for(int idx(0); idx < thread_count; ++idx)
+    {
+        threads.emplace_back(lookup, std::cref(done), std::ref(count));
+    }
+
+    for(int idx(0); idx < reload_count; ++idx)
+    {
+        tld_result const r(tld_reload_tlds(nullptr, 1));
+        if(r != TLD_RESULT_SUCCESS)
+        {
+            fprintf(stderr, "error: tld_reload_tlds() failed with %d.\n", r);
+            ++err_count;
+        }
+
+        // a reload which fails leaves the current TLDs in place
+        //
+        if(idx % 10 == 0
+        && tld_reload_tlds("/this/file/does/not/exist.tld", 0) != TLD_RESULT_NOT_FOUND)
+        {
+            fprintf(stderr, "error: tld_reload_tlds() of a missing file did not return TLD_RESULT_NOT_FOUND.\n");
+            ++err_count;
+        }
+    }
+
+    done = true;
+    for(auto & t : threads)
+    {
+        t.join();
+    }
+
+    if(verbose)
+    {
+        printf("%d threads ran %ld lookups during %d reloads\n", thread_count, count.load(), reload_count);
+    }
+
+    // the results must be the same once the threads are done
+    //
+    for(std::size_t idx(0); idx < g_expected.size(); ++idx)
+    {
+        tld_info info;
+        tld_result const r(tld(g_domains[idx], &info));
+        if(r != g_expected[idx].f_result
+        || info.f_tld_index != g_expected[idx].f_tld_index
+        || g_expected[idx].f_country != info.f_country)
+        {
+            error(g_domains[idx], "did not return the expected result after reloading");
+        }
+    }
+}
+
+
+void test_free()
+{
+    // the non-thread safe functions must also release the reloaded TLDs
+    //
+    tld_free_tlds();
+    if(tld_get_tlds() != nullptr)
+    {
+        fprintf(stderr, "error: tld_get_tlds() did not return nullptr after tld_free_tlds().\n");
+        ++err_count;
+    }
+
+    tld_info info;
+    if(tld(g_domains[0], &info) != g_expected[0].f_result
+    || info.f_tld_index != g_expected[0].f_tld_index)
+    {
+        error(g_domains[0], "did not return the expected result after tld_free_tlds()");
+    }
+
+    if(tld_reload_tlds(nullptr, 1) != TLD_RESULT_SUCCESS
+    || tld_load_tlds(nullptr, 1) != TLD_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "error: tld_reload_tlds() followed by tld_load_tlds() failed.\n");
+        ++err_count;
+    }
+
+    if(tld(g_domains[0], &info) != g_expected[0].f_result
+    || info.f_tld_index != g_expected[0].f_tld_index)
+    {
+        error(g_domains[0], "did not return the expected result after tld_load_tlds()");
+    }
+
+    tld_free_tlds();
+}
+
+
+int main(int argc, char *argv[])
+{
+    printf("testing tld reload version %s\n", tld_version());
+
+    if(argc > 1)
+    {
+        if(strcmp(argv[1], "-v") == 0)
+        {
+            verbose = 1;
+        }
+    }
+
+    load_expected();
+
+    int thread_count(std::thread::hardware_concurrency());
+    if(thread_count < 4)
+    {
+        thread_count = 4;
+    }
+    else if(thread_count > 16)
+    {
+        thread_count = 16;
+    }
+
+    test_reload(thread_count, 200);
+    test_free();
+
+    if(err_count)
+    {
+        fprintf(stderr, "%d error%s occured.\n",
+                    err_count.load(), err_count != 1 ? "s" : "");
+    }
+    exit(err_count ? 1 : 0);
+}
+
+/* vim: ts=4 sw=4 et
+ */
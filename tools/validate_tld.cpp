@@ -61,6 +61,9 @@ const char *schemes = "afp,adiumxtra,aw,beshare,bolo,cap,coap,crid,dns,feed,file
 /// Hold a list of schemes as defined by the end user.
 char const * user_schemes = nullptr;
 
+/// The compiled version of the schemes currently in use.
+tld_protocols * compiled_schemes = nullptr;
+
 /** \brief Check the parameter as a URI.
  *
  * This function verifies that the URI is valid.
@@ -78,8 +81,11 @@ void check_uri(char const * uri)
     else
     {
         struct tld_info info;
-        char const * s(user_schemes == nullptr ? schemes : user_schemes);
-        result = tld_check_uri(uri, &info, s, 0);
+        if(compiled_schemes == nullptr)
+        {
+            compiled_schemes = tld_protocols_compile(user_schemes == nullptr ? schemes : user_schemes);
+        }
+        result = tld_check_uri_ex(uri, strlen(uri), &info, compiled_schemes, 0);
 
         if(verbose)
         {
@@ -206,6 +212,8 @@ int main(int argc, char *argv[])
                         fprintf(stderr, "error: the --schemes option requires a list of comma separated schemes.\n");
                     }
                     user_schemes = argv[i];
+                    tld_protocols_free(compiled_schemes);
+                    compiled_schemes = nullptr;
                 }
                 else if(strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
                 {
@@ -225,6 +233,8 @@ int main(int argc, char *argv[])
             ++err_count;
         }
 
+        tld_protocols_free(compiled_schemes);
+
         return err_count > 0 ? 1 : 0;
     }
     catch(std::exception const& e) // LCOV_EXCL_LINE